@@ -0,0 +1,261 @@
+#include "ASTCache.h"
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/ASTContext.h>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/FileSystemOptions.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Serialization/ASTReader.h>
+#include <clang/Serialization/ModuleFile.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+namespace {
+
+std::string
+getAbsolutePath(
+    llvm::StringRef Directory,
+    llvm::StringRef Path
+)
+{
+    llvm::SmallString<256> Out(Path);
+    if (llvm::sys::path::is_relative(Out))
+    {
+        Out.clear();
+        llvm::sys::path::append(Out, Directory, Path);
+    }
+
+    llvm::sys::path::remove_dots(Out, true);
+    return std::string(Out.str());
+}
+
+void
+getDependencies(
+    clang::ASTUnit &AST,
+    std::vector<std::string> *Dependencies
+)
+{
+    // An AST loaded from the cache only knows of the files that it was built
+    // from through its reader, whereas all the files of a parsed one are
+    // registered in its source manager.
+
+    if (clang::ASTReader *Reader = AST.getASTReader().get())
+    {
+        Reader->visitInputFiles(
+            Reader->getModuleManager().getPrimaryModule(),
+            true,
+            false,
+            [Dependencies](
+                const clang::serialization::InputFile &Input,
+                bool IsSystem
+            )
+            {
+                if (auto File = Input.getFile())
+                {
+                    Dependencies->push_back(File->getName().str());
+                }
+            }
+        );
+        return;
+    }
+
+    const clang::SourceManager &SourceMgr = AST.getSourceManager();
+    for (
+        auto It = SourceMgr.fileinfo_begin();
+        It != SourceMgr.fileinfo_end();
+        ++It
+    )
+    {
+        Dependencies->push_back(It->first->getName().str());
+    }
+}
+
+std::unique_ptr<clang::ASTUnit>
+loadAST(
+    llvm::StringRef Path,
+    const clang::PCHContainerOperations &PCHContainerOps
+)
+{
+    if (!llvm::sys::fs::exists(Path))
+    {
+        return nullptr;
+    }
+
+    // Stale entries are expected, so failing to load one is not reported.
+
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> Diagnostics
+        = clang::CompilerInstance::createDiagnostics(
+            new clang::DiagnosticOptions(),
+            new clang::IgnoringDiagConsumer(),
+            true
+        );
+
+    std::unique_ptr<clang::ASTUnit> AST = clang::ASTUnit::LoadFromASTFile(
+        Path.str(),
+        PCHContainerOps.getRawReader(),
+        clang::ASTUnit::LoadEverything,
+        Diagnostics,
+        clang::FileSystemOptions()
+    );
+    if (!AST)
+    {
+        return nullptr;
+    }
+
+    // But the diagnostics describing the replacements are.
+
+    auto *Printer = new clang::TextDiagnosticPrinter(
+        llvm::errs(), &Diagnostics->getDiagnosticOptions()
+    );
+    Diagnostics->setClient(Printer, true);
+    Printer->BeginSourceFile(AST->getLangOpts(), &AST->getPreprocessor());
+    return AST;
+}
+
+} // anonymous namespace
+
+ASTCache::
+ASTCache(
+    std::string Directory,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+) :
+    Directory(std::move(Directory)),
+    FileSystem(std::move(FileSystem)),
+    PCHContainerOps(std::make_shared<clang::PCHContainerOperations>())
+{
+}
+
+int
+ASTCache::
+process(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath,
+    clang::tooling::ClangTool *Tool,
+    clang::ASTConsumer *Consumer,
+    std::vector<std::string> *Dependencies
+)
+{
+    std::string EntryPath = this->getEntryPath(Compilations, SourcePath);
+
+    std::unique_ptr<clang::ASTUnit> AST;
+    if (!EntryPath.empty())
+    {
+        AST = loadAST(EntryPath, *this->PCHContainerOps);
+    }
+
+    int Status = 0;
+    if (!AST)
+    {
+        std::vector<std::unique_ptr<clang::ASTUnit>> ASTs;
+        Status = Tool->buildASTs(ASTs);
+
+        // A source with more than one compile command would need one entry
+        // per command, so these are left out of the cache.
+
+        if (ASTs.size() != 1)
+        {
+            for (std::unique_ptr<clang::ASTUnit> &Other : ASTs)
+            {
+                clang::ASTContext &Context = Other->getASTContext();
+                Consumer->Initialize(Context);
+                Consumer->HandleTranslationUnit(Context);
+                getDependencies(*Other, Dependencies);
+            }
+
+            return ASTs.empty() ? 1 : Status;
+        }
+
+        AST = std::move(ASTs.front());
+
+        if (Status == 0 && !EntryPath.empty())
+        {
+            std::error_code Error = llvm::sys::fs::create_directories(
+                llvm::sys::path::parent_path(EntryPath)
+            );
+            if (Error || AST->Save(EntryPath))
+            {
+                llvm::errs()
+                    << "Failed saving the AST of "
+                    << SourcePath
+                    << " to the cache.\n";
+            }
+        }
+    }
+
+    clang::ASTContext &Context = AST->getASTContext();
+    Consumer->Initialize(Context);
+    Consumer->HandleTranslationUnit(Context);
+    getDependencies(*AST, Dependencies);
+    return Status;
+}
+
+std::string
+ASTCache::
+getEntryPath(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath
+)
+{
+    std::vector<clang::tooling::CompileCommand> Commands
+        = Compilations.getCompileCommands(SourcePath);
+    if (Commands.size() != 1)
+    {
+        return std::string();
+    }
+
+    const clang::tooling::CompileCommand &Command = Commands.front();
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = this->FileSystem->getBufferForFile(
+            getAbsolutePath(Command.Directory, Command.Filename)
+        );
+    if (!Buffer)
+    {
+        return std::string();
+    }
+
+    llvm::SHA1 Hasher;
+    Hasher.update(Command.Directory);
+    for (const std::string &Argument : Command.CommandLine)
+    {
+        Hasher.update(llvm::StringRef("\0", 1));
+        Hasher.update(Argument);
+    }
+
+    Hasher.update(llvm::StringRef("\0", 1));
+    Hasher.update((*Buffer)->getBuffer());
+
+    // Spread the entries across subdirectories to keep these small.
+
+    std::string Key = llvm::toHex(Hasher.final(), true);
+    llvm::SmallString<256> Out(this->Directory);
+    llvm::sys::path::append(
+        Out, llvm::StringRef(Key).take_front(2), Key + ".ast"
+    );
+    return std::string(Out.str());
+}
+
+} // namespace pxr
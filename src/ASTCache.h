@@ -0,0 +1,70 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+// On-disk cache of the ASTs of the sources, serialized with
+// `ASTUnit::Save()`.
+//
+// Entries are looked up by hashing the compile commands of a source and its
+// content. Loading an entry also checks that none of the headers that it was
+// built from changed since, in which case the source is parsed again.
+//
+// Safe to use from multiple threads.
+
+class ASTCache
+{
+public:
+    // The sources are read through the given file system, and the entries
+    // from the disk.
+
+    ASTCache(
+        std::string Directory,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+    );
+
+    // Load the AST of the given source from the cache, or parse it with
+    // the given tool and save it, then pass it to the consumer. The files that
+    // the AST was built from are added to the dependencies.
+    //
+    // Return the same values as `ClangTool::run()`.
+
+    int
+    process(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath,
+        clang::tooling::ClangTool *Tool,
+        clang::ASTConsumer *Consumer,
+        std::vector<std::string> *Dependencies
+    );
+
+private:
+    // Path of the entry for the given source, or an empty string if the
+    // source can't be read.
+
+    std::string
+    getEntryPath(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath
+    );
+
+    std::string Directory;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem;
+    std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps;
+};
+
+} // namespace pxr
+
+#endif // AST_CACHE_H
@@ -0,0 +1,109 @@
+#include "Apply.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileUtilities.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+bool
+pxr::
+applyReplacements(
+    const std::map<std::string, clang::tooling::Replacements> &FileToReplacements,
+    llvm::vfs::FileSystem &FileSystem,
+    std::map<std::string, std::string> *FileToContent
+)
+{
+    for (const auto &FileAndReplaces : FileToReplacements)
+    {
+        const std::string &FilePath = FileAndReplaces.first;
+
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+            = FileSystem.getBufferForFile(FilePath);
+        if (!Buffer)
+        {
+            llvm::errs()
+                << "Failed reading the file "
+                << FilePath
+                << ": "
+                << Buffer.getError().message()
+                << ".\n";
+            return false;
+        }
+
+        llvm::Expected<std::string> Content
+            = clang::tooling::applyAllReplacements(
+                (*Buffer)->getBuffer(), FileAndReplaces.second
+            );
+        if (!Content)
+        {
+            llvm::errs()
+                << "Failed applying replacements for file "
+                << FilePath
+                << ": "
+                << llvm::toString(Content.takeError())
+                << ".\n";
+            return false;
+        }
+
+        (*FileToContent)[FilePath] = std::move(*Content);
+    }
+
+    return true;
+}
+
+void
+pxr::
+dumpFiles(
+    const std::map<std::string, std::string> &FileToContent,
+    llvm::raw_ostream &Stream
+)
+{
+    for (const auto &FileAndContent : FileToContent)
+    {
+        Stream
+            << "============== "
+            << FileAndContent.first
+            << " ==============\n"
+            << FileAndContent.second
+            << "\n============================================\n";
+    }
+}
+
+bool
+pxr::
+writeFiles(
+    const std::map<std::string, std::string> &FileToContent
+)
+{
+    for (const auto &FileAndContent : FileToContent)
+    {
+        const std::string &FilePath = FileAndContent.first;
+
+        // Write to a temporary file first, like the rewriter does, so that
+        // a failure never leaves a file half-written.
+
+        if (
+            llvm::Error Error = llvm::writeFileAtomically(
+                FilePath + "-%%%%%%%%", FilePath, FileAndContent.second
+            )
+        )
+        {
+            llvm::errs()
+                << "Failed writing the changes to the file "
+                << FilePath
+                << ": "
+                << llvm::toString(std::move(Error))
+                << ".\n";
+            return false;
+        }
+    }
+
+    return true;
+}
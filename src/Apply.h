@@ -0,0 +1,36 @@
+#ifndef APPLY_H
+#define APPLY_H
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <string>
+
+namespace pxr {
+
+// Apply the replacements onto the content of their files, read through
+// the given file system, and return the resulting content of each file.
+
+bool
+applyReplacements(
+    const std::map<std::string, clang::tooling::Replacements> &FileToReplacements,
+    llvm::vfs::FileSystem &FileSystem,
+    std::map<std::string, std::string> *FileToContent
+);
+
+void
+dumpFiles(
+    const std::map<std::string, std::string> &FileToContent,
+    llvm::raw_ostream &Stream
+);
+
+bool
+writeFiles(
+    const std::map<std::string, std::string> &FileToContent
+);
+
+} // namespace pxr
+
+#endif // APPLY_H
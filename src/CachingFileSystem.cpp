@@ -0,0 +1,224 @@
+#include "CachingFileSystem.h"
+
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace pxr {
+
+namespace {
+
+// File whose content is owned by the cache, which outlives it.
+
+class CachedFile
+    : public llvm::vfs::File
+{
+public:
+    CachedFile(
+        llvm::vfs::Status Status,
+        const llvm::MemoryBuffer &Content
+    ) :
+        Status(std::move(Status)),
+        Content(Content)
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status() override
+    {
+        return this->Status;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+    getBuffer(
+        const llvm::Twine &Name,
+        int64_t FileSize,
+        bool RequiresNullTerminator,
+        bool IsVolatile
+    ) override
+    {
+        // The content was read with a null terminator, so it can always be
+        // handed over as is.
+
+        return llvm::MemoryBuffer::getMemBuffer(
+            this->Content.getBuffer(), Name.str(), RequiresNullTerminator
+        );
+    }
+
+    std::error_code
+    close() override
+    {
+        return std::error_code();
+    }
+
+private:
+    llvm::vfs::Status Status;
+    const llvm::MemoryBuffer &Content;
+};
+
+} // anonymous namespace
+
+CachingFileSystem::
+CachingFileSystem(
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+    std::shared_ptr<Cache> Files
+) :
+    llvm::vfs::ProxyFileSystem(std::move(FileSystem)),
+    Files(std::move(Files))
+{
+}
+
+llvm::ErrorOr<llvm::vfs::Status>
+CachingFileSystem::
+status(
+    const llvm::Twine &Path
+)
+{
+    llvm::SmallString<256> Key;
+    Path.toVector(Key);
+    if (this->makeAbsolute(Key))
+    {
+        return this->getUnderlyingFS().status(Path);
+    }
+
+    Cache::Shard &Bucket = this->Files->getShard(Key);
+    {
+        std::lock_guard<std::mutex> Lock(Bucket.Mutex);
+        auto It = Bucket.Entries.find(Key);
+        if (It != Bucket.Entries.end())
+        {
+            if (It->second.Error)
+            {
+                return It->second.Error;
+            }
+
+            return llvm::vfs::Status::copyWithNewName(
+                It->second.Status, Path
+            );
+        }
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status> Status
+        = this->getUnderlyingFS().status(Key);
+
+    std::lock_guard<std::mutex> Lock(Bucket.Mutex);
+    Cache::Entry &Cached = Bucket.Entries[Key];
+    if (Status)
+    {
+        Cached.Status = *Status;
+        return llvm::vfs::Status::copyWithNewName(*Status, Path);
+    }
+
+    Cached.Error = Status.getError();
+    return Cached.Error;
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+CachingFileSystem::
+openFileForRead(
+    const llvm::Twine &Path
+)
+{
+    llvm::SmallString<256> Key;
+    Path.toVector(Key);
+    if (this->makeAbsolute(Key))
+    {
+        return this->getUnderlyingFS().openFileForRead(Path);
+    }
+
+    Cache::Shard &Bucket = this->Files->getShard(Key);
+    {
+        std::lock_guard<std::mutex> Lock(Bucket.Mutex);
+        auto It = Bucket.Entries.find(Key);
+        if (It != Bucket.Entries.end())
+        {
+            if (It->second.Error)
+            {
+                return It->second.Error;
+            }
+
+            if (It->second.Content)
+            {
+                return std::unique_ptr<llvm::vfs::File>(
+                    std::make_unique<CachedFile>(
+                        llvm::vfs::Status::copyWithNewName(
+                            It->second.Status, Path
+                        ),
+                        *It->second.Content
+                    )
+                );
+            }
+        }
+    }
+
+    // Reading the file outside of the lock can have two threads reading
+    // the same file at once, in which case the first content stored wins.
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> File
+        = this->getUnderlyingFS().openFileForRead(Key);
+    if (!File)
+    {
+        std::lock_guard<std::mutex> Lock(Bucket.Mutex);
+        Bucket.Entries[Key].Error = File.getError();
+        return File.getError();
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status> Status = (*File)->status();
+    if (!Status)
+    {
+        return Status.getError();
+    }
+
+    // Directories, pipes, and such are not cached.
+
+    if (!Status->isRegularFile())
+    {
+        return File;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Content
+        = (*File)->getBuffer(Key, Status->getSize(), true, false);
+    if (!Content)
+    {
+        return Content.getError();
+    }
+
+    std::lock_guard<std::mutex> Lock(Bucket.Mutex);
+    Cache::Entry &Cached = Bucket.Entries[Key];
+    if (!Cached.Content)
+    {
+        Cached.Error = std::error_code();
+        Cached.Status = *Status;
+        Cached.Content = std::move(*Content);
+    }
+
+    return std::unique_ptr<llvm::vfs::File>(
+        std::make_unique<CachedFile>(
+            llvm::vfs::Status::copyWithNewName(Cached.Status, Path),
+            *Cached.Content
+        )
+    );
+}
+
+CachingFileSystem::Cache::Shard &
+CachingFileSystem::Cache::
+getShard(
+    llvm::StringRef Path
+)
+{
+    return this->Shards[llvm::hash_value(Path) % ShardCount];
+}
+
+} // namespace pxr
@@ -0,0 +1,90 @@
+#ifndef CACHING_FILE_SYSTEM_H
+#define CACHING_FILE_SYSTEM_H
+
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <mutex>
+#include <system_error>
+
+namespace pxr {
+
+// File system remembering the status and the content of the files read
+// through it, including the paths that don't exist, such as the ones tried
+// by the header search along each ‘-I’ directory.
+//
+// The files read are recorded into a cache meant to be shared by all
+// the translation units of a run, after which it is to be discarded since it
+// never checks for changes made to the files. Each worker thread wraps its own
+// file system around the cache, since the working directory that the relative
+// paths are resolved against is changed for each translation unit, and
+// the entries are keyed on the absolute paths.
+//
+// The cache is safe to use from multiple threads, but not the file system.
+
+class CachingFileSystem
+    : public llvm::vfs::ProxyFileSystem
+{
+public:
+    class Cache;
+
+    CachingFileSystem(
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+        std::shared_ptr<Cache> Files
+    );
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(
+        const llvm::Twine &Path
+    ) override;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(
+        const llvm::Twine &Path
+    ) override;
+
+private:
+    std::shared_ptr<Cache> Files;
+};
+
+// Status and content of the files read through the file systems sharing it.
+
+class CachingFileSystem::Cache
+{
+private:
+    friend class CachingFileSystem;
+
+    struct Entry
+    {
+        std::error_code Error;
+        llvm::vfs::Status Status;
+        std::unique_ptr<llvm::MemoryBuffer> Content;
+    };
+
+    // Entries are spread across several maps, each with its own lock, for
+    // the worker threads not to wait on each other.
+
+    struct Shard
+    {
+        std::mutex Mutex;
+        llvm::StringMap<Entry> Entries;
+    };
+
+    static constexpr unsigned ShardCount = 32;
+
+    Shard &
+    getShard(
+        llvm::StringRef Path
+    );
+
+    Shard Shards[ShardCount];
+};
+
+} // namespace pxr
+
+#endif // CACHING_FILE_SYSTEM_H
@@ -0,0 +1,456 @@
+#include "ChangedRanges.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FileUtilities.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/SHA1.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+namespace {
+
+/* Paths                                                           O-(''Q)
+   -------------------------------------------------------------------------- */
+
+std::string
+normalizePath(
+    llvm::StringRef Path,
+    llvm::StringRef BaseDirectory
+)
+{
+    llvm::SmallString<256> Out(Path);
+    if (BaseDirectory.empty())
+    {
+        llvm::sys::fs::make_absolute(Out);
+    }
+    else
+    {
+        llvm::sys::fs::make_absolute(BaseDirectory, Out);
+    }
+
+    llvm::sys::path::remove_dots(Out, true);
+    return std::string(Out.str());
+}
+
+/* Diffs                                                           O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Parse a hunk range such as ‘12,3’, where a missing count stands for 1.
+
+bool
+parseHunkRange(
+    llvm::StringRef Text,
+    unsigned *Start,
+    unsigned *Count
+)
+{
+    llvm::StringRef StartText;
+    llvm::StringRef CountText;
+    std::tie(StartText, CountText) = Text.split(',');
+
+    *Count = 1;
+    return (
+        !StartText.getAsInteger(10, *Start)
+        && (CountText.empty() || !CountText.getAsInteger(10, *Count))
+    );
+}
+
+// Parse a hunk header such as ‘@@ -12,3 +12,4 @@ context’.
+
+bool
+parseHunkHeader(
+    llvm::StringRef Line,
+    unsigned *OldCount,
+    unsigned *NewStart,
+    unsigned *NewCount
+)
+{
+    llvm::SmallVector<llvm::StringRef, 4> Parts;
+    Line.split(Parts, ' ', 3, false);
+
+    unsigned OldStart;
+    return (
+        Parts.size() >= 3
+        && Parts[1].consume_front("-")
+        && Parts[2].consume_front("+")
+        && parseHunkRange(Parts[1], &OldStart, OldCount)
+        && parseHunkRange(Parts[2], NewStart, NewCount)
+    );
+}
+
+// Convert the given line numbers, starting at 1, into sorted and disjoint
+// ranges of offsets into the given content.
+
+std::vector<std::pair<unsigned, unsigned>>
+getLineRanges(
+    llvm::StringRef Content,
+    std::vector<unsigned> Lines
+)
+{
+    std::vector<unsigned> LineStarts = {0};
+    for (size_t I = 0; I < Content.size(); ++I)
+    {
+        if (Content[I] == '\n')
+        {
+            LineStarts.push_back(unsigned(I + 1));
+        }
+    }
+
+    std::sort(Lines.begin(), Lines.end());
+
+    std::vector<std::pair<unsigned, unsigned>> Out;
+    for (unsigned Line : Lines)
+    {
+        if (Line == 0 || Line > LineStarts.size())
+        {
+            continue;
+        }
+
+        unsigned Begin = LineStarts[Line - 1];
+        unsigned End
+            = Line < LineStarts.size()
+            ? LineStarts[Line]
+            : unsigned(Content.size());
+
+        if (!Out.empty() && Out.back().second >= Begin)
+        {
+            Out.back().second = std::max(Out.back().second, End);
+            continue;
+        }
+
+        Out.emplace_back(Begin, End);
+    }
+
+    return Out;
+}
+
+/* Git                                                             O-(''Q)
+   -------------------------------------------------------------------------- */
+
+llvm::Error
+runGit(
+    llvm::ArrayRef<llvm::StringRef> Args,
+    std::string *Output
+)
+{
+    llvm::ErrorOr<std::string> Git = llvm::sys::findProgramByName("git");
+    if (!Git)
+    {
+        return llvm::createStringError(
+            Git.getError(), "Failed finding the ‘git’ executable."
+        );
+    }
+
+    llvm::SmallString<256> OutputPath;
+    if (
+        std::error_code Error = llvm::sys::fs::createTemporaryFile(
+            "pxr-git", "txt", OutputPath
+        )
+    )
+    {
+        return llvm::createStringError(
+            Error,
+            "Failed creating a temporary file: %s.",
+            Error.message().c_str()
+        );
+    }
+
+    llvm::FileRemover Remover(OutputPath);
+
+    std::vector<llvm::StringRef> Command = {*Git};
+    Command.insert(Command.end(), Args.begin(), Args.end());
+
+    llvm::Optional<llvm::StringRef> Redirects[] = {
+        llvm::None,
+        llvm::StringRef(OutputPath),
+        llvm::None,
+    };
+
+    std::string Message;
+    if (
+        llvm::sys::ExecuteAndWait(
+            *Git, Command, llvm::None, Redirects, 0, 0, &Message
+        ) != 0
+    )
+    {
+        return llvm::createStringError(
+            llvm::inconvertibleErrorCode(),
+            "Failed running ‘git %s’%s%s.",
+            llvm::join(Args, " ").c_str(),
+            Message.empty() ? "" : ": ",
+            Message.c_str()
+        );
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(OutputPath);
+    if (!Buffer)
+    {
+        return llvm::createStringError(
+            Buffer.getError(),
+            "Failed reading the output of ‘git %s’.",
+            llvm::join(Args, " ").c_str()
+        );
+    }
+
+    *Output = (*Buffer)->getBuffer().str();
+    return llvm::Error::success();
+}
+
+} // anonymous namespace
+
+/* Class Implementation                                            O-(''Q)
+   -------------------------------------------------------------------------- */
+
+llvm::Expected<ChangedRanges>
+ChangedRanges::
+parse(
+    llvm::StringRef Patch,
+    llvm::StringRef BaseDirectory
+)
+{
+    llvm::StringMap<std::vector<unsigned>> FileLines;
+    std::vector<unsigned> *Lines = nullptr;
+
+    // Hunks are consumed by counting their lines rather than by looking at
+    // the lines that follow, which could start with ‘+++’ or ‘@@’ too.
+
+    unsigned OldLeft = 0;
+    unsigned NewLeft = 0;
+    unsigned NewLine = 0;
+
+    llvm::SmallVector<llvm::StringRef> PatchLines;
+    Patch.split(PatchLines, '\n');
+    for (llvm::StringRef Line : PatchLines)
+    {
+        if (Line.startswith("\\"))
+        {
+            // No newline at end of file.
+            continue;
+        }
+
+        if (OldLeft > 0 || NewLeft > 0)
+        {
+            char Kind = Line.empty() ? ' ' : Line[0];
+            if (Kind == '+')
+            {
+                if (Lines)
+                {
+                    Lines->push_back(NewLine);
+                }
+
+                ++NewLine;
+                NewLeft -= std::min(NewLeft, 1u);
+            }
+            else if (Kind == '-')
+            {
+                if (Lines)
+                {
+                    Lines->push_back(NewLine - 1);
+                    Lines->push_back(NewLine);
+                }
+
+                OldLeft -= std::min(OldLeft, 1u);
+            }
+            else
+            {
+                ++NewLine;
+                OldLeft -= std::min(OldLeft, 1u);
+                NewLeft -= std::min(NewLeft, 1u);
+            }
+
+            continue;
+        }
+
+        if (Line.startswith("+++ "))
+        {
+            llvm::StringRef Path = Line.drop_front(4).split('\t').first;
+            if (Path == "/dev/null")
+            {
+                Lines = nullptr;
+                continue;
+            }
+
+            Path.consume_front("b/");
+            Lines = &FileLines[normalizePath(Path, BaseDirectory)];
+            continue;
+        }
+
+        if (Line.startswith("@@ "))
+        {
+            if (!parseHunkHeader(Line, &OldLeft, &NewLine, &NewLeft))
+            {
+                return llvm::createStringError(
+                    llvm::inconvertibleErrorCode(),
+                    "Invalid hunk header ‘%s’.",
+                    Line.str().c_str()
+                );
+            }
+
+            // Hunks that only remove lines start at the line before them.
+
+            if (NewLeft == 0)
+            {
+                ++NewLine;
+            }
+        }
+    }
+
+    ChangedRanges Out;
+    for (const auto &It : FileLines)
+    {
+        // Files removed or not readable have no lines to refactor.
+
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+            = llvm::MemoryBuffer::getFile(It.getKey());
+        if (!Buffer)
+        {
+            continue;
+        }
+
+        std::vector<std::pair<unsigned, unsigned>> Ranges
+            = getLineRanges((*Buffer)->getBuffer(), It.getValue());
+        if (!Ranges.empty())
+        {
+            Out.Files[It.getKey()] = std::move(Ranges);
+        }
+    }
+
+    llvm::SHA1 Hasher;
+    Hasher.update(BaseDirectory);
+    Hasher.update(Patch);
+    Out.Key = llvm::toHex(Hasher.final(), true);
+    return Out;
+}
+
+llvm::Expected<ChangedRanges>
+ChangedRanges::
+fromFile(
+    llvm::StringRef Path
+)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(Path);
+    if (!Buffer)
+    {
+        return llvm::createStringError(
+            Buffer.getError(),
+            "Failed reading the diff %s: %s.",
+            Path.str().c_str(),
+            Buffer.getError().message().c_str()
+        );
+    }
+
+    llvm::SmallString<256> BaseDirectory;
+    llvm::sys::fs::current_path(BaseDirectory);
+    return parse((*Buffer)->getBuffer(), BaseDirectory);
+}
+
+llvm::Expected<ChangedRanges>
+ChangedRanges::
+fromRevision(
+    llvm::StringRef Revision
+)
+{
+    // Git outputs the paths relative to the top-level directory of
+    // the repository, whichever the current directory is.
+
+    std::string TopLevel;
+    if (llvm::Error Error = runGit({"rev-parse", "--show-toplevel"}, &TopLevel))
+    {
+        return std::move(Error);
+    }
+
+    std::string Patch;
+    if (
+        llvm::Error Error = runGit(
+            {
+                "diff",
+                "--no-color",
+                "--no-ext-diff",
+                "--src-prefix=a/",
+                "--dst-prefix=b/",
+                "-U0",
+                Revision,
+                "--",
+            },
+            &Patch
+        )
+    )
+    {
+        return std::move(Error);
+    }
+
+    return parse(Patch, llvm::StringRef(TopLevel).trim());
+}
+
+bool
+ChangedRanges::
+contains(
+    llvm::StringRef Path
+) const
+{
+    return this->Files.count(normalizePath(Path, llvm::StringRef()));
+}
+
+bool
+ChangedRanges::
+overlaps(
+    const clang::tooling::Replacement &Replacement
+) const
+{
+    auto It = this->Files.find(
+        normalizePath(Replacement.getFilePath(), llvm::StringRef())
+    );
+    if (It == this->Files.end())
+    {
+        return false;
+    }
+
+    // Insertions have no length but still belong to the line that they
+    // are inserted into.
+
+    unsigned Begin = Replacement.getOffset();
+    unsigned End = Begin + std::max(Replacement.getLength(), 1u);
+
+    const std::vector<std::pair<unsigned, unsigned>> &Ranges = It->getValue();
+    auto Range = std::upper_bound(
+        Ranges.begin(),
+        Ranges.end(),
+        Begin,
+        [](unsigned Offset, const std::pair<unsigned, unsigned> &Range)
+        {
+            return Offset < Range.second;
+        }
+    );
+
+    return Range != Ranges.end() && Range->first < End;
+}
+
+const std::string &
+ChangedRanges::
+getKey() const
+{
+    return this->Key;
+}
+
+} // namespace pxr
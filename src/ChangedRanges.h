@@ -0,0 +1,81 @@
+#ifndef CHANGED_RANGES_H
+#define CHANGED_RANGES_H
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+// Lines added or modified by a unified diff, such as the ones output by
+// ‘git diff’, stored as byte ranges into the current content of each file.
+//
+// Lines removed by the diff mark the lines around them as changed, so that
+// the code left where they were still counts as touched.
+
+class ChangedRanges
+{
+public:
+    // Parse the given diff, with the relative paths that it contains being
+    // resolved against the given directory once stripped of the ‘b/’ prefix
+    // added by git. Each file changed is read to find the offsets of its
+    // lines.
+
+    static llvm::Expected<ChangedRanges>
+    parse(
+        llvm::StringRef Patch,
+        llvm::StringRef BaseDirectory
+    );
+
+    // Read the diff from a file, with its relative paths being resolved
+    // against the current directory.
+
+    static llvm::Expected<ChangedRanges>
+    fromFile(
+        llvm::StringRef Path
+    );
+
+    // Diff between the given git revision and the working tree of the
+    // repository found in the current directory.
+
+    static llvm::Expected<ChangedRanges>
+    fromRevision(
+        llvm::StringRef Revision
+    );
+
+    // Whether the diff changes any line of the given file.
+
+    bool
+    contains(
+        llvm::StringRef Path
+    ) const;
+
+    // Whether the given replacement touches a changed line. Insertions
+    // count as touching the line that they are inserted into.
+
+    bool
+    overlaps(
+        const clang::tooling::Replacement &Replacement
+    ) const;
+
+    // Hash identifying the changes, to key what depends on them with.
+
+    const std::string &
+    getKey() const;
+
+private:
+    ChangedRanges() = default;
+
+    // Sorted and disjoint ranges of offsets, with exclusive ends.
+    llvm::StringMap<std::vector<std::pair<unsigned, unsigned>>> Files;
+    std::string Key;
+};
+
+} // namespace pxr
+
+#endif // CHANGED_RANGES_H
@@ -0,0 +1,878 @@
+#include "Executor.h"
+#include "ASTCache.h"
+#include "CachingFileSystem.h"
+#include "ChangedRanges.h"
+#include "FileScope.h"
+#include "MatcherRegistry.h"
+#include "PrecompiledHeaders.h"
+#include "PreambleCache.h"
+#include "ReplacementCache.h"
+#include "ReplacementStore.h"
+#include "TraversalScope.h"
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/FileSystemOptions.h>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Core/Replacement.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+namespace {
+
+/* Timings                                                         O-(''Q)
+   -------------------------------------------------------------------------- */
+
+void
+loadTimings(
+    llvm::StringRef Path,
+    llvm::StringMap<double> *Timings
+)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(Path);
+    if (!Buffer)
+    {
+        return;
+    }
+
+    // Each line is made of a duration in seconds and of a file path,
+    // separated by a tab character.
+
+    llvm::SmallVector<llvm::StringRef> Lines;
+    (*Buffer)->getBuffer().split(Lines, '\n', -1, false);
+    for (llvm::StringRef Line : Lines)
+    {
+        llvm::StringRef Seconds;
+        llvm::StringRef File;
+        std::tie(Seconds, File) = Line.split('\t');
+
+        double Value;
+        if (File.empty() || Seconds.getAsDouble(Value))
+        {
+            continue;
+        }
+
+        (*Timings)[File] = Value;
+    }
+}
+
+void
+saveTimings(
+    llvm::StringRef Path,
+    const llvm::StringMap<double> &Timings
+)
+{
+    std::error_code Error;
+    llvm::raw_fd_ostream Stream(Path, Error, llvm::sys::fs::OF_Text);
+    if (Error)
+    {
+        llvm::errs()
+            << "Failed writing the timings to "
+            << Path
+            << ": "
+            << Error.message()
+            << ".\n";
+        return;
+    }
+
+    std::vector<llvm::StringRef> Files;
+    for (const auto &It : Timings)
+    {
+        Files.push_back(It.getKey());
+    }
+
+    std::sort(Files.begin(), Files.end());
+    for (llvm::StringRef File : Files)
+    {
+        Stream
+            << llvm::format("%.3f", Timings.lookup(File))
+            << '\t'
+            << File
+            << '\n';
+    }
+}
+
+// Order the sources from the most expensive to the cheapest to process so
+// that a slow file doesn't end up being processed alone at the tail of a run.
+// Files without any recorded timing have their cost estimated from their size.
+
+std::vector<size_t>
+scheduleSources(
+    llvm::ArrayRef<std::string> SourcePaths,
+    const llvm::StringMap<double> &Timings
+)
+{
+    std::vector<double> Sizes(SourcePaths.size(), 0.0);
+    double KnownSeconds = 0.0;
+    double KnownSize = 0.0;
+    for (size_t I = 0; I < SourcePaths.size(); ++I)
+    {
+        uint64_t Size;
+        if (!llvm::sys::fs::file_size(SourcePaths[I], Size))
+        {
+            Sizes[I] = double(Size);
+        }
+
+        auto It = Timings.find(SourcePaths[I]);
+        if (It != Timings.end())
+        {
+            KnownSeconds += It->getValue();
+            KnownSize += Sizes[I];
+        }
+    }
+
+    double SecondsPerByte = KnownSize > 0.0 ? KnownSeconds / KnownSize : 1.0;
+
+    std::vector<double> Costs(SourcePaths.size());
+    for (size_t I = 0; I < SourcePaths.size(); ++I)
+    {
+        auto It = Timings.find(SourcePaths[I]);
+        Costs[I]
+            = It != Timings.end() ? It->getValue() : Sizes[I] * SecondsPerByte;
+    }
+
+    std::vector<size_t> Schedule(SourcePaths.size());
+    std::iota(Schedule.begin(), Schedule.end(), 0);
+    std::stable_sort(
+        Schedule.begin(),
+        Schedule.end(),
+        [&Costs](size_t A, size_t B)
+        {
+            return Costs[A] > Costs[B];
+        }
+    );
+
+    return Schedule;
+}
+
+// Whether the given source is a header, going by its extension, as
+// the compilation databases only list the translation units.
+
+bool
+isHeader(
+    llvm::StringRef Path
+)
+{
+    llvm::StringRef Extension = llvm::sys::path::extension(Path);
+    return (
+        Extension == ".h"
+        || Extension == ".hh"
+        || Extension == ".hpp"
+        || Extension == ".hxx"
+    );
+}
+
+/* Consumers                                                       O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Adapter for `newFrontendActionFactory()` to create the AST consumers
+// of the actions from a function.
+
+struct ConsumerSource
+{
+    std::function<std::unique_ptr<clang::ASTConsumer>()> Create;
+
+    std::unique_ptr<clang::ASTConsumer>
+    newASTConsumer()
+    {
+        return this->Create();
+    }
+};
+
+// Run the actions of another factory with the preamble of their main file
+// loaded from the cache.
+
+class PreambleActionFactory
+    : public clang::tooling::FrontendActionFactory
+{
+public:
+    PreambleActionFactory(
+        clang::tooling::FrontendActionFactory *Factory,
+        PreambleCache *Preambles
+    ) :
+        Factory(Factory),
+        Preambles(Preambles)
+    {
+    }
+
+    std::unique_ptr<clang::FrontendAction>
+    create() override
+    {
+        return this->Factory->create();
+    }
+
+    bool
+    runInvocation(
+        std::shared_ptr<clang::CompilerInvocation> Invocation,
+        clang::FileManager *Files,
+        std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+        clang::DiagnosticConsumer *DiagConsumer
+    ) override
+    {
+        std::shared_ptr<const clang::PrecompiledPreamble> Preamble
+            = this->Preambles->apply(
+                Invocation.get(),
+                &Files->getVirtualFileSystem(),
+                PCHContainerOps
+            );
+        return this->Factory->runInvocation(
+            std::move(Invocation),
+            Files,
+            std::move(PCHContainerOps),
+            DiagConsumer
+        );
+    }
+
+private:
+    clang::tooling::FrontendActionFactory *Factory;
+    PreambleCache *Preambles;
+};
+
+/* Results                                                         O-(''Q)
+   -------------------------------------------------------------------------- */
+
+int
+combineStatuses(
+    llvm::ArrayRef<int> Statuses
+)
+{
+    // Same as `ClangTool::run()`: 1 if a file failed to be processed,
+    // 2 if some were skipped, and 0 otherwise.
+
+    int Out = 0;
+    for (int Status : Statuses)
+    {
+        if (Status == 1)
+        {
+            return 1;
+        }
+
+        Out = std::max(Out, Status);
+    }
+
+    return Out;
+}
+
+} // anonymous namespace
+
+/* Class Implementation                                            O-(''Q)
+   -------------------------------------------------------------------------- */
+
+Executor::
+Executor(
+    const clang::tooling::CompilationDatabase &Compilations,
+    CallbackFactory Factory,
+    ExecutorOptions Options
+) :
+    Compilations(Compilations),
+    Factory(std::move(Factory)),
+    Options(std::move(Options)),
+    FileSystems(
+        []()
+        {
+            // Unlike the one from `getRealFileSystem()`, each of these has its
+            // own working directory rather than the one of the process.
+
+            return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(
+                llvm::vfs::createPhysicalFileSystem().release()
+            );
+        }
+    )
+{
+    if (!this->Options.TimingsPath.empty())
+    {
+        loadTimings(this->Options.TimingsPath, &this->Timings);
+    }
+}
+
+Executor::
+~Executor() = default;
+
+void
+Executor::
+setResultSink(
+    ResultSink Sink
+)
+{
+    this->Sink = std::move(Sink);
+}
+
+void
+Executor::
+setLexicalFilter(
+    LexicalFilter Filter
+)
+{
+    this->Filter = std::move(Filter);
+}
+
+void
+Executor::
+setFileSystemFactory(
+    FileSystemFactory FileSystems
+)
+{
+    this->FileSystems = std::move(FileSystems);
+}
+
+int
+Executor::
+run(
+    llvm::ArrayRef<std::string> AllSourcePaths,
+    ReplacementStore *Store
+)
+{
+    // A header handed over to the sink as soon as it is processed could be
+    // written while the sources including it are still queued or being
+    // parsed, and these would then see it half refactored.
+
+    if (this->Sink)
+    {
+        for (const std::string &SourcePath : AllSourcePaths)
+        {
+            if (isHeader(SourcePath))
+            {
+                llvm::errs()
+                    << "The header "
+                    << SourcePath
+                    << " can't be streamed, since the sources including it "
+                    << "could be parsed after it is written.\n";
+                return 1;
+            }
+        }
+    }
+
+    // Replacements only ever land in the main file of a translation unit,
+    // so the sources left untouched by the diff can't have any to keep.
+    // This doesn't hold for unity units, which are generated files.
+
+    std::vector<std::string> ChangedSourcePaths;
+    if (this->Options.Changes && !this->Options.UnityUnits)
+    {
+        for (const std::string &SourcePath : AllSourcePaths)
+        {
+            if (this->Options.Changes->contains(SourcePath))
+            {
+                ChangedSourcePaths.push_back(SourcePath);
+            }
+        }
+
+        AllSourcePaths = ChangedSourcePaths;
+    }
+
+    std::vector<std::string> SourcePaths;
+    for (
+        size_t I = this->Options.ShardIndex;
+        I < AllSourcePaths.size();
+        I += this->Options.ShardCount
+    )
+    {
+        SourcePaths.push_back(AllSourcePaths[I]);
+    }
+
+    std::vector<size_t> Schedule = scheduleSources(SourcePaths, this->Timings);
+
+    // The headers are left for the translation units including them to
+    // claim, and the ones that none claimed are parsed on their own last.
+
+    std::unique_ptr<HeaderClaims> Claims;
+    std::vector<size_t> HeaderSchedule;
+    if (this->Options.HeadersFromIncluders)
+    {
+        std::vector<std::string> HeaderPaths;
+        std::vector<size_t> UnitSchedule;
+        for (size_t Index : Schedule)
+        {
+            if (isHeader(SourcePaths[Index]))
+            {
+                HeaderPaths.push_back(SourcePaths[Index]);
+                HeaderSchedule.push_back(Index);
+            }
+            else
+            {
+                UnitSchedule.push_back(Index);
+            }
+        }
+
+        Claims = std::make_unique<HeaderClaims>(HeaderPaths);
+        Schedule = std::move(UnitSchedule);
+    }
+
+    HeaderClaims *ActiveClaims = Claims.get();
+
+    // The cached files are only valid for as long as this run lasts.
+
+    std::shared_ptr<CachingFileSystem::Cache> CachedFiles;
+    if (this->Options.CacheFiles)
+    {
+        CachedFiles = std::make_shared<CachingFileSystem::Cache>();
+    }
+
+    auto CreateFileSystem = [&]()
+    {
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> Out
+            = this->FileSystems();
+        if (CachedFiles)
+        {
+            Out = new CachingFileSystem(std::move(Out), CachedFiles);
+        }
+
+        return Out;
+    };
+
+    // The caches shared by the workers only read the files through their
+    // absolute paths, so they can share a file system whose working directory
+    // never changes.
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+        = CreateFileSystem();
+
+    // The saved ASTs depend on the precompiled header that they were parsed
+    // with, which is rebuilt on each run, so both can't be used together.
+
+    std::unique_ptr<ASTCache> ASTs;
+    if (!this->Options.ASTCacheDirectory.empty())
+    {
+        ASTs = std::make_unique<ASTCache>(
+            this->Options.ASTCacheDirectory,
+            FileSystem
+        );
+    }
+
+    // The preambles are kept for as long as the executor is, with the files
+    // that they depend on being checked for changes before each use.
+
+    if (this->Options.Preambles && !ASTs && !this->Preambles)
+    {
+        this->Preambles = std::make_unique<PreambleCache>();
+    }
+
+    std::unique_ptr<PrecompiledHeaders> Headers;
+    if (
+        !ASTs
+        && !this->Preambles
+        && !this->Options.PrefixHeader.empty()
+    )
+    {
+        llvm::Expected<std::unique_ptr<PrecompiledHeaders>> ExpectedHeaders
+            = PrecompiledHeaders::create(
+                this->Options.PrefixHeader,
+                this->Options.PCHDirectory,
+                FileSystem
+            );
+        if (!ExpectedHeaders)
+        {
+            llvm::errs()
+                << llvm::toString(ExpectedHeaders.takeError())
+                << "\n";
+            return 1;
+        }
+
+        Headers = std::move(*ExpectedHeaders);
+    }
+
+    // The replacements found in a translation unit depend on the headers
+    // that it claimed, which vary with the order in which the files happen
+    // to be processed, so these can't be cached.
+
+    std::unique_ptr<ReplacementCache> Cache;
+    if (
+        !this->Options.CacheDirectory.empty()
+        && !this->Options.HeadersFromIncluders
+    )
+    {
+        Cache = std::make_unique<ReplacementCache>(
+            this->Options.CacheDirectory,
+            this->Options.CacheKey,
+            FileSystem
+        );
+    }
+
+    std::vector<std::unique_ptr<ReplacementStore>> Results(SourcePaths.size());
+    std::vector<int> Statuses(SourcePaths.size(), 0);
+    std::vector<double> Durations(SourcePaths.size(), 0.0);
+
+    // Whether each source was parsed or found in the cache, the skipped ones
+    // having no timing worth saving. Not a ‘std::vector<bool>’, since the
+    // workers set their flags concurrently.
+
+    std::vector<char> Processed(SourcePaths.size(), 0);
+    std::atomic<size_t> Next(0);
+    std::atomic<size_t> Skipped(0);
+    std::mutex Mutex;
+
+    // Unity units are only made of ‘#include’ directives, which tell nothing
+    // about the sources that they pull in, and neither does the content of
+    // a source tell about the headers that it would claim.
+
+    LexicalFilter Filter;
+    if (
+        this->Options.LexicalPrefilter
+        && !this->Options.UnityUnits
+        && !this->Options.HeadersFromIncluders
+    )
+    {
+        Filter = this->Filter;
+    }
+
+    // The results handed over to the sink are released right away, so that
+    // the memory used doesn't grow with the number of sources.
+
+    auto Flush = [&](size_t Index)
+    {
+        if (!this->Sink)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (!this->Sink(*Results[Index]))
+        {
+            Statuses[Index] = 1;
+        }
+
+        Results[Index]->clear();
+    };
+
+    // Each worker owns its file manager, match finder, and tool instance,
+    // and keeps picking the next scheduled file until none is left.
+
+    auto Work = [&]()
+    {
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> WorkerFileSystem
+            = CreateFileSystem();
+        llvm::IntrusiveRefCntPtr<clang::FileManager> Files(
+            new clang::FileManager(
+                clang::FileSystemOptions(), WorkerFileSystem
+            )
+        );
+
+        ReplacementStore Replacements;
+        Replacements.setDiagnosticsEnabled(Store->getDiagnosticsEnabled());
+        if (this->Options.Changes)
+        {
+            Replacements.setFilter(
+                [this](const clang::tooling::Replacement &Replacement)
+                {
+                    return this->Options.Changes->overlaps(Replacement);
+                }
+            );
+        }
+
+        // The match finder overwrites the profiling records at the end of
+        // each translation unit, so they are summed after each file.
+
+        llvm::StringMap<llvm::TimeRecord> Records;
+        llvm::StringMap<llvm::TimeRecord> MatcherTimes;
+        clang::ast_matchers::MatchFinder::MatchFinderOptions FinderOptions;
+        if (this->Options.ProfileMatchers)
+        {
+            FinderOptions.CheckProfiling.emplace(Records);
+        }
+
+        FileScope Scope;
+        Scope.setHeaderClaims(ActiveClaims);
+        Scope.setUnityUnits(this->Options.UnityUnits);
+
+        clang::ast_matchers::MatchFinder Finder(std::move(FinderOptions));
+        MatcherRegistry Registry(
+            &Finder, &Scope, this->Options.ProfileMatchers
+        );
+        auto Callback = this->Factory(&Replacements, &Registry);
+
+        ConsumerSource Consumers;
+        Consumers.Create = [&]()
+        {
+            return newMainFileScopeConsumer(Finder.newASTConsumer(), &Scope);
+        };
+
+        DependencyRecorder Dependencies;
+        std::unique_ptr<clang::tooling::FrontendActionFactory> BaseFactory
+            = clang::tooling::newFrontendActionFactory(
+                &Consumers, Cache ? &Dependencies : nullptr
+            );
+
+        std::unique_ptr<clang::tooling::FrontendActionFactory> PreambleFactory;
+        if (this->Preambles)
+        {
+            PreambleFactory = std::make_unique<PreambleActionFactory>(
+                BaseFactory.get(), this->Preambles.get()
+            );
+        }
+
+        clang::tooling::FrontendActionFactory *ActionFactory
+            = PreambleFactory ? PreambleFactory.get() : BaseFactory.get();
+
+        for (
+            size_t I = Next++;
+            I < Schedule.size();
+            I = Next++
+        )
+        {
+            size_t Index = Schedule[I];
+            Results[Index] = std::make_unique<ReplacementStore>();
+
+            // Sources that can't be read are left for the tool to report.
+
+            if (Filter)
+            {
+                llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Content
+                    = WorkerFileSystem->getBufferForFile(SourcePaths[Index]);
+                if (Content && !Filter((*Content)->getBuffer()))
+                {
+                    ++Skipped;
+                    continue;
+                }
+            }
+
+            // Keep the previous timing of the sources found in the cache
+            // since these will need to be parsed again once they change.
+
+            if (
+                Cache
+                && Cache->load(
+                    this->Compilations,
+                    SourcePaths[Index],
+                    Results[Index].get()
+                )
+            )
+            {
+                Durations[Index] = this->Timings.lookup(SourcePaths[Index]);
+                Processed[Index] = 1;
+                Flush(Index);
+                continue;
+            }
+
+            clang::tooling::ClangTool Tool(
+                this->Compilations,
+                SourcePaths[Index],
+                std::make_shared<clang::PCHContainerOperations>(),
+                WorkerFileSystem,
+                Files
+            );
+
+            if (Headers)
+            {
+                std::string PCHPath
+                    = Headers->find(this->Compilations, SourcePaths[Index]);
+                if (!PCHPath.empty())
+                {
+                    Tool.appendArgumentsAdjuster(
+                        clang::tooling::getInsertArgumentAdjuster(
+                            {"-include-pch", PCHPath},
+                            clang::tooling::ArgumentInsertPosition::BEGIN
+                        )
+                    );
+                }
+            }
+
+            std::vector<std::string> SourceDependencies;
+
+            auto Start = std::chrono::steady_clock::now();
+            if (ASTs)
+            {
+                std::unique_ptr<clang::ASTConsumer> Consumer
+                    = Consumers.Create();
+                Statuses[Index] = ASTs->process(
+                    this->Compilations,
+                    SourcePaths[Index],
+                    &Tool,
+                    Consumer.get(),
+                    &SourceDependencies
+                );
+            }
+            else
+            {
+                Statuses[Index] = Tool.run(ActionFactory);
+                SourceDependencies = Dependencies.takeDependencies();
+            }
+
+            std::chrono::duration<double> Elapsed
+                = std::chrono::steady_clock::now() - Start;
+
+            Durations[Index] = Elapsed.count();
+            Processed[Index] = 1;
+            Results[Index]->merge(Replacements);
+            Replacements.clear();
+
+            // The replacements dropped for want of their file leave the
+            // source only partly refactored.
+
+            if (!Results[Index]->getUnresolved().empty())
+            {
+                Statuses[Index] = 1;
+            }
+
+            // Conflicts are only reported when they are found, so the sources
+            // having some are parsed again on each run.
+
+            if (
+                Cache
+                && Statuses[Index] == 0
+                && Results[Index]->getConflicts().empty()
+            )
+            {
+                Cache->save(
+                    this->Compilations,
+                    SourcePaths[Index],
+                    SourceDependencies,
+                    *Results[Index]
+                );
+            }
+
+            Flush(Index);
+
+            for (const auto &It : Records)
+            {
+                MatcherTimes[It.getKey()] += It.getValue();
+            }
+
+            Records.clear();
+        }
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        for (const auto &It : MatcherTimes)
+        {
+            this->MatcherTimes[It.getKey()] += It.getValue();
+        }
+
+        Registry.addMatchCounts(&this->MatchCounts);
+    };
+
+    unsigned Jobs = this->Options.Jobs;
+    if (Jobs == 0)
+    {
+        Jobs = llvm::hardware_concurrency().compute_thread_count();
+    }
+
+    auto RunWorkers = [&]()
+    {
+        unsigned Count
+            = std::max(1u, std::min(Jobs, unsigned(Schedule.size())));
+        if (Count == 1)
+        {
+            Work();
+            return;
+        }
+
+        std::vector<std::thread> Workers;
+        for (unsigned I = 0; I < Count; ++I)
+        {
+            Workers.emplace_back(Work);
+        }
+
+        for (std::thread &Worker : Workers)
+        {
+            Worker.join();
+        }
+    };
+
+    RunWorkers();
+
+    // The headers parsed on their own don't claim the ones that they
+    // include since these are scheduled already.
+
+    if (Claims)
+    {
+        Schedule.clear();
+        for (size_t Index : HeaderSchedule)
+        {
+            if (!Claims->isClaimed(SourcePaths[Index]))
+            {
+                Schedule.push_back(Index);
+            }
+        }
+
+        ActiveClaims = nullptr;
+        Next = 0;
+        RunWorkers();
+    }
+
+    // Merge in the order in which the files were given rather than in
+    // the order in which they were processed so that, when conflicts arise,
+    // the same replacements win as when running all the files in sequence.
+    // The claimed headers have no results of their own.
+
+    for (size_t I = 0; I < SourcePaths.size(); ++I)
+    {
+        if (Results[I])
+        {
+            Store->merge(*Results[I]);
+        }
+    }
+
+    if (Skipped > 0)
+    {
+        llvm::errs()
+            << "Skipped "
+            << Skipped
+            << " files without anything to refactor.\n";
+    }
+
+    if (!this->Options.TimingsPath.empty())
+    {
+        for (size_t I = 0; I < SourcePaths.size(); ++I)
+        {
+            if (Processed[I])
+            {
+                this->Timings[SourcePaths[I]] = Durations[I];
+            }
+        }
+
+        saveTimings(this->Options.TimingsPath, this->Timings);
+    }
+
+    return combineStatuses(Statuses);
+}
+
+const llvm::StringMap<llvm::TimeRecord> &
+Executor::
+getMatcherTimes() const
+{
+    return this->MatcherTimes;
+}
+
+const llvm::StringMap<size_t> &
+Executor::
+getMatchCounts() const
+{
+    return this->MatchCounts;
+}
+
+} // namespace pxr
@@ -0,0 +1,183 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include "LexicalFilter.h"
+
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace pxr {
+
+class ChangedRanges;
+class MatcherRegistry;
+class PreambleCache;
+class ReplacementStore;
+
+// Create the match callback of a tool and register its matchers onto
+// the given registry. Each worker thread calls it once to get its own instance.
+using CallbackFactory = std::function<
+    std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>(
+        ReplacementStore *Store,
+        MatcherRegistry *Registry
+    )
+>;
+
+// Create the file system that the sources and the files that they include are
+// read through. Each worker thread calls it once to get its own instance,
+// since the working directory of the file system is changed to the one of
+// each compile command that the worker runs.
+using FileSystemFactory = std::function<
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>()
+>;
+
+// Receive the replacements found in a source as soon as it is processed,
+// rather than once all the sources are. Only called by one worker at a time.
+// Returning false marks the source as failed.
+using ResultSink = std::function<
+    bool(
+        const ReplacementStore &Result
+    )
+>;
+
+struct ExecutorOptions
+{
+    // Number of worker threads, or 0 to use all the available cores.
+    unsigned Jobs = 1;
+
+    // File recording how long each source took to be processed, used to
+    // schedule the slowest ones first. It is updated after each run.
+    std::string TimingsPath;
+
+    // Only process the files at the positions ‘ShardIndex + k * ShardCount’.
+    unsigned ShardIndex = 0;
+    unsigned ShardCount = 1;
+
+    // Record the time spent in each matcher.
+    bool ProfileMatchers = false;
+
+    // Header made of the ‘#include’ directives that most sources start with,
+    // to precompile into the given directory and to parse these sources with.
+    std::string PrefixHeader;
+    std::string PCHDirectory;
+
+    // Directory caching the replacements found in each source, reused for as
+    // long as the source and the files that it depends on don't change.
+    // The key identifies the tool and the options affecting its replacements.
+    std::string CacheDirectory;
+    std::string CacheKey;
+
+    // Directory caching the AST of each source, loaded instead of parsing
+    // the source for as long as the files that it was built from don't change.
+    // The precompiled headers are then not used.
+    std::string ASTCacheDirectory;
+
+    // Keep the precompiled preamble of each source across runs, to only parse
+    // what comes after the ‘#include’ directives when running it again.
+    // The precompiled headers are then not used.
+    bool Preambles = false;
+
+    // Share the status and the content of the files read, including the
+    // failed lookups along the include paths, across all the sources
+    // processed by a run.
+    bool CacheFiles = false;
+
+    // Skip the sources that the lexical filter of the tool, if any, rules
+    // out without parsing them.
+    bool LexicalPrefilter = false;
+
+    // Only process the sources changed by a diff, and only keep
+    // the replacements touching the lines that it changed.
+    std::shared_ptr<const ChangedRanges> Changes;
+
+    // Refactor the headers given as sources from within the first
+    // translation unit including them rather than on their own, and only
+    // parse on their own the ones that no translation unit included.
+    // The replacement cache is then not used.
+    bool HeadersFromIncluders = false;
+
+    // Treat the sources as unity units and refactor the sources that they
+    // include instead. The lexical prefilter is then not used, and a diff
+    // doesn't restrict the units to process, only the replacements kept.
+    bool UnityUnits = false;
+};
+
+class Executor
+{
+public:
+    Executor(
+        const clang::tooling::CompilationDatabase &Compilations,
+        CallbackFactory Factory,
+        ExecutorOptions Options
+    );
+
+    ~Executor();
+
+    // Filter used to skip the sources that can't have anything to refactor
+    // when the lexical prefilter is enabled.
+
+    void
+    setLexicalFilter(
+        LexicalFilter Filter
+    );
+
+    // Hand the replacements of each source over to the given sink as soon as
+    // the source is processed. These are then not merged into the store
+    // given to `run()`, which fails if any of the sources is a header.
+
+    void
+    setResultSink(
+        ResultSink Sink
+    );
+
+    // Read the sources and the files that they include through the file
+    // systems from the given factory rather than from the disk.
+
+    void
+    setFileSystemFactory(
+        FileSystemFactory FileSystems
+    );
+
+    int
+    run(
+        llvm::ArrayRef<std::string> SourcePaths,
+        ReplacementStore *Store
+    );
+
+    // Time spent in each matcher, summed over all the files processed.
+    // Only filled when profiling the matchers.
+
+    const llvm::StringMap<llvm::TimeRecord> &
+    getMatcherTimes() const;
+
+    // Number of matches of each matcher, summed over all the files parsed.
+    // Only filled when profiling the matchers.
+
+    const llvm::StringMap<size_t> &
+    getMatchCounts() const;
+
+private:
+    const clang::tooling::CompilationDatabase &Compilations;
+    CallbackFactory Factory;
+    LexicalFilter Filter;
+    ResultSink Sink;
+    ExecutorOptions Options;
+    FileSystemFactory FileSystems;
+    std::unique_ptr<PreambleCache> Preambles;
+    llvm::StringMap<double> Timings;
+    llvm::StringMap<llvm::TimeRecord> MatcherTimes;
+    llvm::StringMap<size_t> MatchCounts;
+};
+
+} // namespace pxr
+
+#endif // EXECUTOR_H
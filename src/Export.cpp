@@ -0,0 +1,49 @@
+#include "Export.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <clang/Tooling/ReplacementsYaml.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/YAMLTraits.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <string>
+#include <system_error>
+
+bool
+pxr::
+exportReplacements(
+    llvm::StringRef Path,
+    llvm::StringRef MainSourceFile,
+    const std::map<std::string, clang::tooling::Replacements> &FileToReplacements
+)
+{
+    clang::tooling::TranslationUnitReplacements TU;
+    TU.MainSourceFile = MainSourceFile.str();
+    for (const auto &FileAndReplaces : FileToReplacements)
+    {
+        TU.Replacements.insert(
+            TU.Replacements.end(),
+            FileAndReplaces.second.begin(),
+            FileAndReplaces.second.end()
+        );
+    }
+
+    std::error_code Error;
+    llvm::raw_fd_ostream Stream(Path, Error, llvm::sys::fs::OF_Text);
+    if (Error)
+    {
+        llvm::errs()
+            << "Failed exporting the replacements to "
+            << Path
+            << ": "
+            << Error.message()
+            << ".\n";
+        return false;
+    }
+
+    llvm::yaml::Output YAML(Stream);
+    YAML << TU;
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <map>
+#include <string>
+
+namespace pxr {
+
+// Write the replacements in the YAML format understood by
+// ‘clang-apply-replacements’, as a single translation unit document.
+
+bool
+exportReplacements(
+    llvm::StringRef Path,
+    llvm::StringRef MainSourceFile,
+    const std::map<std::string, clang::tooling::Replacements> &FileToReplacements
+);
+
+} // namespace pxr
+
+#endif // EXPORT_H
@@ -0,0 +1,60 @@
+#include "FilePattern.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/GlobPattern.h>
+#include <llvm/Support/Regex.h>
+
+#include <memory>
+#include <string>
+
+llvm::Expected<pxr::FilePattern>
+pxr::FilePattern::
+create(
+    llvm::StringRef Pattern
+)
+{
+    FilePattern Out;
+
+    if (Pattern.startswith("^"))
+    {
+        auto Regex = std::make_shared<llvm::Regex>(Pattern);
+
+        std::string Error;
+        if (!Regex->isValid(Error))
+        {
+            return llvm::createStringError(
+                llvm::inconvertibleErrorCode(),
+                "Invalid file pattern ‘%s’: %s.",
+                Pattern.str().c_str(),
+                Error.c_str()
+            );
+        }
+
+        Out.Regex = std::move(Regex);
+        return Out;
+    }
+
+    llvm::Expected<llvm::GlobPattern> Glob = llvm::GlobPattern::create(Pattern);
+    if (!Glob)
+    {
+        return Glob.takeError();
+    }
+
+    Out.Glob = std::move(*Glob);
+    return Out;
+}
+
+bool
+pxr::FilePattern::
+match(
+    llvm::StringRef Path
+) const
+{
+    if (this->Regex)
+    {
+        return this->Regex->match(Path);
+    }
+
+    return this->Glob && this->Glob->match(Path);
+}
@@ -0,0 +1,39 @@
+#ifndef FILE_PATTERN_H
+#define FILE_PATTERN_H
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/GlobPattern.h>
+#include <llvm/Support/Regex.h>
+
+#include <memory>
+
+namespace pxr {
+
+// Pattern matching file paths, either as a glob pattern, or as a regular
+// expression if it starts with ‘^’.
+
+class FilePattern
+{
+public:
+    static llvm::Expected<FilePattern>
+    create(
+        llvm::StringRef Pattern
+    );
+
+    bool
+    match(
+        llvm::StringRef Path
+    ) const;
+
+private:
+    FilePattern() = default;
+
+    llvm::Optional<llvm::GlobPattern> Glob;
+    std::shared_ptr<const llvm::Regex> Regex;
+};
+
+} // namespace pxr
+
+#endif // FILE_PATTERN_H
@@ -0,0 +1,245 @@
+#include "FileScope.h"
+
+#include <clang/Basic/FileEntry.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include <mutex>
+#include <string>
+
+namespace pxr {
+
+namespace {
+
+// Paths of the file entries are resolved the same way, so that a header
+// listed through a symbolic link is still recognized once included.
+
+std::string
+getRealPath(
+    llvm::StringRef Path
+)
+{
+    llvm::SmallString<256> Out;
+    if (llvm::sys::fs::real_path(Path, Out))
+    {
+        Out = Path;
+        llvm::sys::fs::make_absolute(Out);
+        llvm::sys::path::remove_dots(Out, true);
+    }
+
+    return std::string(Out.str());
+}
+
+// Whether the given file is a source rather than a header, going by its
+// extension. Unity units only pull in sources.
+
+bool
+isSourceFile(
+    llvm::StringRef Path
+)
+{
+    llvm::StringRef Extension = llvm::sys::path::extension(Path);
+    return (
+        Extension == ".cpp"
+        || Extension == ".cc"
+        || Extension == ".cxx"
+        || Extension == ".c"
+    );
+}
+
+} // anonymous namespace
+
+/* Header Claims                                                   O-(''Q)
+   -------------------------------------------------------------------------- */
+
+HeaderClaims::
+HeaderClaims(
+    llvm::ArrayRef<std::string> HeaderPaths
+)
+{
+    for (const std::string &Path : HeaderPaths)
+    {
+        this->Headers[getRealPath(Path)] = false;
+    }
+}
+
+bool
+HeaderClaims::
+claim(
+    llvm::StringRef Path
+)
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    auto It = this->Headers.find(Path);
+    if (It == this->Headers.end() || It->getValue())
+    {
+        return false;
+    }
+
+    It->getValue() = true;
+    return true;
+}
+
+bool
+HeaderClaims::
+isClaimed(
+    llvm::StringRef Path
+) const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    return this->Headers.lookup(getRealPath(Path));
+}
+
+/* File Scope                                                      O-(''Q)
+   -------------------------------------------------------------------------- */
+
+void
+FileScope::
+setHeaderClaims(
+    HeaderClaims *Claims
+)
+{
+    this->Claims = Claims;
+}
+
+void
+FileScope::
+setUnityUnits(
+    bool Enabled
+)
+{
+    this->UnityUnits = Enabled;
+}
+
+void
+FileScope::
+reset(
+    const clang::SourceManager &SourceMgr
+)
+{
+    this->SourceMgr = &SourceMgr;
+    this->Files.clear();
+    this->Claimed.clear();
+}
+
+bool
+FileScope::
+claim(
+    clang::FileID ID
+)
+{
+    if (ID == this->SourceMgr->getMainFileID())
+    {
+        return true;
+    }
+
+    if ((!this->Claims && !this->UnityUnits) || ID.isInvalid())
+    {
+        return false;
+    }
+
+    auto It = this->Files.find(ID);
+    if (It != this->Files.end())
+    {
+        return It->second;
+    }
+
+    bool Out = false;
+    if (const clang::FileEntry *Entry = this->SourceMgr->getFileEntryForID(ID))
+    {
+        // The real path of an entry is only made absolute, without resolving
+        // its symbolic links, so it is resolved the same way as the headers.
+
+        llvm::StringRef Name = Entry->tryGetRealPathName();
+        if (Name.empty())
+        {
+            Name = Entry->getName();
+        }
+
+        std::string Path = getRealPath(Name);
+
+        // The members of a unity unit are the sources that it directly
+        // includes, which no other unit includes, so there is no need to
+        // claim them.
+
+        if (
+            this->UnityUnits
+            && isSourceFile(Path)
+            && this->SourceMgr->isInMainFile(this->SourceMgr->getIncludeLoc(ID))
+        )
+        {
+            Out = true;
+        }
+        else if (this->Claims)
+        {
+            Out = this->Claimed.count(Path) || this->Claims->claim(Path);
+            if (Out)
+            {
+                this->Claimed.insert(Path);
+            }
+        }
+    }
+
+    this->Files[ID] = Out;
+    return Out;
+}
+
+bool
+FileScope::
+contains(
+    clang::FileID ID
+) const
+{
+    return (
+        ID == this->SourceMgr->getMainFileID()
+        || (!this->Files.empty() && this->Files.lookup(ID))
+    );
+}
+
+llvm::SmallVector<clang::FileID, 8>
+FileScope::
+getFiles() const
+{
+    llvm::SmallVector<clang::FileID, 8> Out;
+    Out.push_back(this->SourceMgr->getMainFileID());
+    for (const auto &It : this->Files)
+    {
+        if (It.second)
+        {
+            Out.push_back(It.first);
+        }
+    }
+
+    return Out;
+}
+
+bool
+FileScope::
+containsExpansion(
+    clang::SourceLocation Loc
+) const
+{
+    if (Loc.isInvalid())
+    {
+        return false;
+    }
+
+    // Same as `isExpansionInMainFile()` for the main file.
+
+    Loc = this->SourceMgr->getExpansionLoc(Loc);
+    return (
+        this->SourceMgr->isInMainFile(Loc)
+        || (
+            !this->Files.empty()
+            && this->Files.lookup(this->SourceMgr->getFileID(Loc))
+        )
+    );
+}
+
+} // namespace pxr
@@ -0,0 +1,125 @@
+#ifndef FILE_SCOPE_H
+#define FILE_SCOPE_H
+
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+
+#include <mutex>
+#include <string>
+
+namespace pxr {
+
+// Headers to refactor from within the first translation unit including them,
+// with its exact compile flags, rather than by parsing each of them as a main
+// file with flags interpolated from the ones of its neighbours.
+//
+// Safe to use from multiple threads.
+
+class HeaderClaims
+{
+public:
+    explicit HeaderClaims(
+        llvm::ArrayRef<std::string> HeaderPaths
+    );
+
+    // Mark the given header as refactored by the caller. Return false if it
+    // isn't one of the headers to claim, or if it was already claimed.
+
+    bool
+    claim(
+        llvm::StringRef Path
+    );
+
+    bool
+    isClaimed(
+        llvm::StringRef Path
+    ) const;
+
+private:
+    mutable std::mutex Mutex;
+    llvm::StringMap<bool> Headers;
+};
+
+// Files refactored within the translation unit being processed: its main
+// file, the sources that it includes when it is a unity unit, and the headers
+// that it claimed, if any.
+//
+// Each translation unit claims the headers whose declarations it traverses,
+// before any matching happens, so the same headers are in scope for all
+// the nodes matched within it.
+
+class FileScope
+{
+public:
+    // Claim the headers included by the translation units from the given
+    // claims, or only refactor the main files if null.
+
+    void
+    setHeaderClaims(
+        HeaderClaims *Claims
+    );
+
+    // Treat the main files as unity units, that is files made of ‘#include’
+    // directives pulling in the sources of a library, and refactor each of
+    // these sources as if it was a main file.
+
+    void
+    setUnityUnits(
+        bool Enabled
+    );
+
+    // Start a new translation unit.
+
+    void
+    reset(
+        const clang::SourceManager &SourceMgr
+    );
+
+    // Whether the given file is in scope, claiming it if it is a header that
+    // no other translation unit claimed yet. The sources included by a unity
+    // unit are always in scope.
+
+    bool
+    claim(
+        clang::FileID ID
+    );
+
+    // Whether the given file is in scope, without claiming it.
+
+    bool
+    contains(
+        clang::FileID ID
+    ) const;
+
+    // Files in scope, starting with the main file.
+
+    llvm::SmallVector<clang::FileID, 8>
+    getFiles() const;
+
+    // Whether the expansion location of the given location is in scope.
+
+    bool
+    containsExpansion(
+        clang::SourceLocation Loc
+    ) const;
+
+private:
+    HeaderClaims *Claims = nullptr;
+    bool UnityUnits = false;
+    const clang::SourceManager *SourceMgr = nullptr;
+    llvm::DenseMap<clang::FileID, bool> Files;
+
+    // Headers claimed by the current translation unit, which can be entered
+    // several times when they have no include guard.
+    llvm::StringSet<> Claimed;
+};
+
+} // namespace pxr
+
+#endif // FILE_SCOPE_H
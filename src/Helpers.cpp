@@ -5,10 +5,59 @@
 #include <clang/Basic/DiagnosticIDs.h>
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Lex/Lexer.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 
 #include <cassert>
 
+namespace {
+
+// Custom diagnostic IDs are registered onto the `DiagnosticIDs` instance of
+// each translation unit, whose lookup builds a key string and searches
+// a map on every call. Only a handful of descriptions are ever used so
+// the IDs are remembered per thread for as long as the instance is in use.
+// Holding a reference onto it guarantees that its address can't be reused
+// by the instance of a later translation unit.
+
+struct DiagIDCache
+{
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs> DiagIDs;
+    llvm::StringMap<unsigned> IDs;
+};
+
+unsigned
+getCustomDiagID(
+    clang::DiagnosticsEngine &DiagEngine,
+    llvm::StringRef Description
+)
+{
+    thread_local DiagIDCache Cache;
+
+    const llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs> &DiagIDs
+        = DiagEngine.getDiagnosticIDs();
+    if (Cache.DiagIDs != DiagIDs)
+    {
+        Cache.DiagIDs = DiagIDs;
+        Cache.IDs.clear();
+    }
+
+    auto It = Cache.IDs.find(Description);
+    if (It != Cache.IDs.end())
+    {
+        return It->getValue();
+    }
+
+    unsigned ID
+        = DiagIDs->getCustomDiagID(
+            clang::DiagnosticIDs::Warning, Description.str()
+        );
+    Cache.IDs[Description] = ID;
+    return ID;
+}
+
+} // anonymous namespace
+
 clang::DiagnosticBuilder
 pxr::
 diag(
@@ -19,11 +68,7 @@ diag(
 {
     assert(Loc.isValid());
     clang::DiagnosticsEngine &DiagEngine = Result.Context->getDiagnostics();
-    unsigned ID
-        = DiagEngine.getDiagnosticIDs()->getCustomDiagID(
-            clang::DiagnosticIDs::Warning, Description.str()
-        );
-    return DiagEngine.Report(Loc, ID);
+    return DiagEngine.Report(Loc, getCustomDiagID(DiagEngine, Description));
 }
 
 clang::StringRef
@@ -0,0 +1,79 @@
+#include "LexicalFilter.h"
+
+#include <clang/Basic/LangOptions.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/TokenKinds.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Lex/Token.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+bool
+pxr::
+containsTokens(
+    llvm::StringRef Content,
+    llvm::ArrayRef<llvm::StringRef> Tokens
+)
+{
+    if (Tokens.empty())
+    {
+        return true;
+    }
+
+    clang::LangOptions LangOpts;
+    LangOpts.CPlusPlus = true;
+    LangOpts.CPlusPlus11 = true;
+    LangOpts.CPlusPlus14 = true;
+    LangOpts.CPlusPlus17 = true;
+
+    clang::Lexer Lexer(
+        clang::SourceLocation(),
+        LangOpts,
+        Content.begin(),
+        Content.begin(),
+        Content.end()
+    );
+
+    // Keywords are lexed as raw identifiers, which have their spelling
+    // pointing into the content, while the punctuators are only known by
+    // their kind.
+
+    size_t Matched = 0;
+    clang::Token Token;
+    while (true)
+    {
+        Lexer.LexFromRawLexer(Token);
+        if (Token.is(clang::tok::eof))
+        {
+            break;
+        }
+
+        llvm::StringRef Spelling;
+        if (Token.is(clang::tok::raw_identifier))
+        {
+            Spelling = Token.getRawIdentifier();
+        }
+        else if (
+            const char *Punctuator
+                = clang::tok::getPunctuatorSpelling(Token.getKind())
+        )
+        {
+            Spelling = Punctuator;
+        }
+
+        // Restarting from the current token is enough for the short
+        // sequences looked for.
+
+        if (Spelling != Tokens[Matched])
+        {
+            Matched = 0;
+        }
+
+        if (Spelling == Tokens[Matched] && ++Matched == Tokens.size())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
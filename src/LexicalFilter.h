@@ -0,0 +1,30 @@
+#ifndef LEXICAL_FILTER_H
+#define LEXICAL_FILTER_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <functional>
+
+namespace pxr {
+
+// Whether a tool could find something to refactor in a source, given its
+// content, without parsing it. Sources for which it returns false are skipped.
+using LexicalFilter = std::function<bool(llvm::StringRef Content)>;
+
+// Whether the given C++ source spells the given sequence of tokens, each
+// being either the spelling of a punctuator or the name of an identifier or
+// of a keyword.
+//
+// The source is lexed in raw mode, so comments and literals are skipped but
+// macros are not expanded and preprocessor directives are not evaluated.
+
+bool
+containsTokens(
+    llvm::StringRef Content,
+    llvm::ArrayRef<llvm::StringRef> Tokens
+);
+
+} // namespace pxr
+
+#endif // LEXICAL_FILTER_H
@@ -0,0 +1,151 @@
+#include "MatcherRegistry.h"
+
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace pxr {
+
+/* Named Callback                                                  O-(''Q)
+   -------------------------------------------------------------------------- */
+
+class MatcherRegistry::NamedCallback
+    : public clang::ast_matchers::MatchFinder::MatchCallback
+{
+public:
+    NamedCallback(
+        llvm::StringRef Name,
+        clang::ast_matchers::MatchFinder::MatchCallback *Target,
+        bool ForwardTranslationUnit
+    ) :
+        Name(Name.str()),
+        Target(Target),
+        ForwardTranslationUnit(ForwardTranslationUnit)
+    {
+    }
+
+    void
+    run(
+        const clang::ast_matchers::MatchFinder::MatchResult &Result
+    ) override
+    {
+        ++this->Matches;
+        this->Target->run(Result);
+    }
+
+    // The match finder notifies each of its callbacks, so only one of
+    // the callbacks forwarding to a same target notifies it in turn.
+
+    void
+    onStartOfTranslationUnit() override
+    {
+        if (this->ForwardTranslationUnit)
+        {
+            this->Target->onStartOfTranslationUnit();
+        }
+    }
+
+    void
+    onEndOfTranslationUnit() override
+    {
+        if (this->ForwardTranslationUnit)
+        {
+            this->Target->onEndOfTranslationUnit();
+        }
+    }
+
+    llvm::StringRef
+    getID() const override
+    {
+        return this->Name;
+    }
+
+    clang::ast_matchers::MatchFinder::MatchCallback *
+    getTarget() const
+    {
+        return this->Target;
+    }
+
+    size_t
+    getMatches() const
+    {
+        return this->Matches;
+    }
+
+private:
+    std::string Name;
+    clang::ast_matchers::MatchFinder::MatchCallback *Target;
+    bool ForwardTranslationUnit;
+    size_t Matches = 0;
+};
+
+/* Class Implementation                                            O-(''Q)
+   -------------------------------------------------------------------------- */
+
+MatcherRegistry::
+MatcherRegistry(
+    clang::ast_matchers::MatchFinder *Finder,
+    FileScope *Scope,
+    bool Profiling
+) :
+    Finder(Finder),
+    Scope(Scope),
+    Profiling(Profiling)
+{
+}
+
+MatcherRegistry::
+~MatcherRegistry() = default;
+
+FileScope *
+MatcherRegistry::
+getFileScope() const
+{
+    return this->Scope;
+}
+
+void
+MatcherRegistry::
+addMatchCounts(
+    llvm::StringMap<size_t> *Counts
+) const
+{
+    for (const std::unique_ptr<NamedCallback> &Callback : this->Callbacks)
+    {
+        (*Counts)[Callback->getID()] += Callback->getMatches();
+    }
+}
+
+clang::ast_matchers::MatchFinder::MatchCallback *
+MatcherRegistry::
+getCallback(
+    llvm::StringRef Name,
+    clang::ast_matchers::MatchFinder::MatchCallback *Callback
+)
+{
+    if (!this->Profiling)
+    {
+        return Callback;
+    }
+
+    bool ForwardTranslationUnit = true;
+    for (const std::unique_ptr<NamedCallback> &Other : this->Callbacks)
+    {
+        if (Other->getTarget() == Callback)
+        {
+            ForwardTranslationUnit = false;
+            break;
+        }
+    }
+
+    this->Callbacks.push_back(
+        std::make_unique<NamedCallback>(Name, Callback, ForwardTranslationUnit)
+    );
+    return this->Callbacks.back().get();
+}
+
+} // namespace pxr
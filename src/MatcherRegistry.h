@@ -0,0 +1,85 @@
+#ifndef MATCHER_REGISTRY_H
+#define MATCHER_REGISTRY_H
+
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+class FileScope;
+
+// Register the matchers of a tool onto a match finder under a name.
+//
+// The match finder records its profiling data per callback, using their ID,
+// but each tool is a single callback shared by all its matchers. When
+// profiling, each matcher is thus given its own callback named after it,
+// which forwards the matches to the tool's callback, and counts them.
+//
+// The matchers are to only match the nodes within the given file scope.
+
+class MatcherRegistry
+{
+public:
+    MatcherRegistry(
+        clang::ast_matchers::MatchFinder *Finder,
+        FileScope *Scope,
+        bool Profiling
+    );
+
+    ~MatcherRegistry();
+
+    MatcherRegistry(
+        const MatcherRegistry &
+    ) = delete;
+
+    MatcherRegistry &
+    operator=(
+        const MatcherRegistry &
+    ) = delete;
+
+    template <typename MatcherT>
+    void
+    addMatcher(
+        llvm::StringRef Name,
+        const MatcherT &Matcher,
+        clang::ast_matchers::MatchFinder::MatchCallback *Callback
+    )
+    {
+        this->Finder->addMatcher(Matcher, this->getCallback(Name, Callback));
+    }
+
+    FileScope *
+    getFileScope() const;
+
+    // Add the number of matches of each matcher to the given counts. Only
+    // counted when profiling.
+
+    void
+    addMatchCounts(
+        llvm::StringMap<size_t> *Counts
+    ) const;
+
+private:
+    class NamedCallback;
+
+    clang::ast_matchers::MatchFinder::MatchCallback *
+    getCallback(
+        llvm::StringRef Name,
+        clang::ast_matchers::MatchFinder::MatchCallback *Callback
+    );
+
+    clang::ast_matchers::MatchFinder *Finder;
+    FileScope *Scope;
+    bool Profiling;
+    std::vector<std::unique_ptr<NamedCallback>> Callbacks;
+};
+
+} // namespace pxr
+
+#endif // MATCHER_REGISTRY_H
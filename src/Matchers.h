@@ -0,0 +1,64 @@
+#ifndef MATCHERS_H
+#define MATCHERS_H
+
+#include "FileScope.h"
+
+#include <clang/AST/DeclBase.h>
+#include <clang/AST/Stmt.h>
+#include <clang/AST/TypeLoc.h>
+#include <clang/ASTMatchers/ASTMatchers.h>
+#include <clang/ASTMatchers/ASTMatchersInternal.h>
+#include <clang/ASTMatchers/ASTMatchersMacros.h>
+
+#include <utility>
+
+namespace pxr {
+
+// Same as `hasAncestor()` for declarations, but walking up their lexical
+// contexts rather than the parent map. The parent map only covers the nodes
+// within the traversal scope, which excludes the declarations from headers.
+
+AST_MATCHER_P(
+    clang::Decl,
+    hasLexicalAncestor,
+    clang::ast_matchers::internal::Matcher<clang::Decl>,
+    InnerMatcher
+)
+{
+    for (
+        const clang::DeclContext *Ctx = Node.getLexicalDeclContext();
+        Ctx;
+        Ctx = Ctx->getLexicalParent()
+    )
+    {
+        clang::ast_matchers::internal::BoundNodesTreeBuilder Result(*Builder);
+        if (
+            InnerMatcher.matches(
+                *clang::Decl::castFromDeclContext(Ctx), Finder, &Result
+            )
+        )
+        {
+            *Builder = std::move(Result);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Same as `isExpansionInMainFile()`, but also matching the nodes expanded in
+// the headers claimed by the translation unit.
+
+AST_POLYMORPHIC_MATCHER_P(
+    isExpansionInFileScope,
+    AST_POLYMORPHIC_SUPPORTED_TYPES(clang::Decl, clang::Stmt, clang::TypeLoc),
+    const FileScope *,
+    Scope
+)
+{
+    return Scope->containsExpansion(Node.getBeginLoc());
+}
+
+} // namespace pxr
+
+#endif // MATCHERS_H
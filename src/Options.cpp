@@ -0,0 +1,398 @@
+#include "ChangedRanges.h"
+#include "Executor.h"
+#include "Options.h"
+#include "Report.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+llvm::cl::opt<unsigned> Jobs(
+    "j",
+    llvm::cl::desc("Number of files to process in parallel (0: all cores)."),
+    llvm::cl::init(1)
+);
+
+llvm::cl::opt<std::string> Timings(
+    "timings",
+    llvm::cl::desc(
+        "File recording the time taken by each file, used to process "
+        "the slowest ones first."
+    )
+);
+
+llvm::cl::opt<std::string> Shard(
+    "shard",
+    llvm::cl::desc(
+        "Only process the files of the shard ‘i/N’, that is the ones at "
+        "the positions ‘i + k * N’ in the list of source files."
+    ),
+    llvm::cl::value_desc("i/N")
+);
+
+llvm::cl::opt<std::string> ExportReplacements(
+    "export-replacements",
+    llvm::cl::desc(
+        "Export the replacements to a YAML file compatible with "
+        "‘clang-apply-replacements’."
+    ),
+    llvm::cl::value_desc("file")
+);
+
+llvm::cl::opt<pxr::ReportFormat> Report(
+    "report",
+    llvm::cl::desc("How to report the replacements found."),
+    llvm::cl::values(
+        clEnumValN(
+            pxr::ReportFormat::Diagnostics,
+            "diagnostics",
+            "One diagnostic per replacement (default)."
+        ),
+        clEnumValN(
+            pxr::ReportFormat::Summary,
+            "summary",
+            "Replacement counts per label and per file."
+        ),
+        clEnumValN(
+            pxr::ReportFormat::JSON,
+            "json",
+            "Replacement counts and conflicts as a JSON document."
+        ),
+        clEnumValN(
+            pxr::ReportFormat::None,
+            "none",
+            "Nothing besides errors and conflicts."
+        )
+    ),
+    llvm::cl::init(pxr::ReportFormat::Diagnostics)
+);
+
+llvm::cl::opt<std::string> ReportFile(
+    "report-file",
+    llvm::cl::desc("File to write the summary or JSON report to (default: stdout)."),
+    llvm::cl::value_desc("file")
+);
+
+llvm::cl::opt<bool> ProfileMatchers(
+    "profile-matchers",
+    llvm::cl::desc(
+        "Report the time spent in each matcher and its number of matches, "
+        "summed over all the files."
+    )
+);
+
+llvm::cl::opt<std::string> PrefixHeader(
+    "prefix-header",
+    llvm::cl::desc(
+        "Header made of the ‘#include’ directives that most sources start "
+        "with, precompiled once per set of compile flags and used to parse "
+        "the sources starting with the same includes."
+    ),
+    llvm::cl::value_desc("file")
+);
+
+llvm::cl::opt<std::string> PCHDirectory(
+    "pch-dir",
+    llvm::cl::desc(
+        "Directory to write the precompiled headers to (default: a "
+        "‘pxr-pch’ directory in the system's temporary directory)."
+    ),
+    llvm::cl::value_desc("directory")
+);
+
+llvm::cl::opt<std::string> CacheDirectory(
+    "cache-dir",
+    llvm::cl::desc(
+        "Directory caching the replacements found in each file, reused until "
+        "the file, its compile command, or any of the files that it includes "
+        "change."
+    ),
+    llvm::cl::value_desc("directory")
+);
+
+llvm::cl::opt<std::string> ASTCacheDirectory(
+    "ast-cache-dir",
+    llvm::cl::desc(
+        "Directory caching the parsed AST of each file, reused until the "
+        "file, its compile command, or any of the files that it includes "
+        "change. Disables the precompiled headers."
+    ),
+    llvm::cl::value_desc("directory")
+);
+
+llvm::cl::opt<bool> CacheFiles(
+    "cache-files",
+    llvm::cl::desc(
+        "Cache the status and the content of the files read, shared across "
+        "all the files processed, instead of going to the file system for "
+        "each of them."
+    )
+);
+
+llvm::cl::opt<bool> LexicalPrefilter(
+    "lexical-prefilter",
+    llvm::cl::desc(
+        "Skip the files whose tokens show that they can't have anything to "
+        "refactor, without parsing them. Ignored by ‘inline-namespaces’, for "
+        "which the tokens of a file can't tell, and along with the unity "
+        "units or the headers refactored from their includers."
+    )
+);
+
+llvm::cl::opt<bool> HeadersFromIncluders(
+    "headers-from-includers",
+    llvm::cl::desc(
+        "Refactor the headers given from within the first file including "
+        "them, with its compile command, instead of parsing them on their "
+        "own. Disables the replacement cache."
+    )
+);
+
+llvm::cl::opt<bool> UnityUnits(
+    "unity-units",
+    llvm::cl::desc(
+        "Treat the files given as unity units, made of ‘#include’ directives "
+        "pulling in the sources of a library, and refactor each of these "
+        "sources as if it was given instead. Not supported when "
+        "disambiguating the symbols."
+    )
+);
+
+llvm::cl::opt<std::string> Diff(
+    "diff",
+    llvm::cl::desc(
+        "Only process the files changed by the given unified diff, and only "
+        "keep the replacements touching the lines that it changed. Relative "
+        "paths are resolved against the current directory."
+    ),
+    llvm::cl::value_desc("patch")
+);
+
+llvm::cl::opt<std::string> Since(
+    "since",
+    llvm::cl::desc(
+        "Same as ‘--diff’ with the changes made since the given revision to "
+        "the git repository found in the current directory, including the "
+        "uncommitted ones."
+    ),
+    llvm::cl::value_desc("revision")
+);
+
+llvm::cl::opt<bool> Stream(
+    "stream",
+    llvm::cl::desc(
+        "Apply and write the replacements of each file as soon as it is "
+        "processed, rather than holding all of them until the end. Only "
+        "supports the diagnostics report, and can't be exported nor used "
+        "with the precompiled headers, nor with headers among the files."
+    )
+);
+
+llvm::cl::opt<std::string> Serve(
+    "serve",
+    llvm::cl::desc(
+        "Keep running and process the files sent by clients on the given "
+        "Unix domain socket, with the compilation database and the "
+        "precompiled preambles of the files kept in memory across requests."
+    ),
+    llvm::cl::value_desc("socket")
+);
+
+// Identify the build of the running tool by hashing its executable, so that
+// cached replacements don't outlive changes to the tool.
+
+std::string
+getToolKey()
+{
+    std::string Path = llvm::sys::fs::getMainExecutable(
+        nullptr, reinterpret_cast<void *>(&getToolKey)
+    );
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(Path);
+    if (!Buffer)
+    {
+        return Path;
+    }
+
+    llvm::SHA1 Hasher;
+    Hasher.update((*Buffer)->getBuffer());
+    return llvm::toHex(Hasher.final(), true);
+}
+
+bool
+parseShard(
+    llvm::StringRef Value,
+    pxr::ExecutorOptions *Options
+)
+{
+    llvm::StringRef Index;
+    llvm::StringRef Count;
+    std::tie(Index, Count) = Value.split('/');
+
+    if (
+        Index.getAsInteger(10, Options->ShardIndex)
+        || Count.getAsInteger(10, Options->ShardCount)
+        || Options->ShardCount == 0
+        || Options->ShardIndex >= Options->ShardCount
+    )
+    {
+        llvm::errs()
+            << "Invalid shard ‘"
+            << Value
+            << "’, expected ‘i/N’ with 0 <= i < N.\n";
+        return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+void
+pxr::
+addCommonOptions(
+    llvm::cl::OptionCategory &Category
+)
+{
+    Jobs.addCategory(Category);
+    Timings.addCategory(Category);
+    Shard.addCategory(Category);
+    ExportReplacements.addCategory(Category);
+    Report.addCategory(Category);
+    ReportFile.addCategory(Category);
+    ProfileMatchers.addCategory(Category);
+    PrefixHeader.addCategory(Category);
+    PCHDirectory.addCategory(Category);
+    CacheDirectory.addCategory(Category);
+    ASTCacheDirectory.addCategory(Category);
+    CacheFiles.addCategory(Category);
+    LexicalPrefilter.addCategory(Category);
+    HeadersFromIncluders.addCategory(Category);
+    UnityUnits.addCategory(Category);
+    Diff.addCategory(Category);
+    Since.addCategory(Category);
+    Stream.addCategory(Category);
+    Serve.addCategory(Category);
+}
+
+bool
+pxr::
+getCommonOptions(
+    pxr::CommonOptions *Options
+)
+{
+    Options->Executor.Jobs = Jobs;
+    Options->Executor.TimingsPath = Timings;
+    Options->Executor.ProfileMatchers = ProfileMatchers;
+    Options->Executor.PrefixHeader = PrefixHeader;
+    Options->Executor.PCHDirectory = PCHDirectory;
+    if (Options->Executor.PCHDirectory.empty())
+    {
+        llvm::SmallString<256> Path;
+        llvm::sys::path::system_temp_directory(true, Path);
+        llvm::sys::path::append(Path, "pxr-pch");
+        Options->Executor.PCHDirectory = std::string(Path.str());
+    }
+
+    Options->Executor.CacheDirectory = CacheDirectory;
+    if (!Options->Executor.CacheDirectory.empty())
+    {
+        Options->Executor.CacheKey = getToolKey();
+    }
+
+    Options->Executor.ASTCacheDirectory = ASTCacheDirectory;
+    Options->Executor.Preambles = !Serve.empty();
+    Options->Executor.CacheFiles = CacheFiles;
+    Options->Executor.LexicalPrefilter = LexicalPrefilter;
+    Options->Executor.HeadersFromIncluders = HeadersFromIncluders;
+    Options->Executor.UnityUnits = UnityUnits;
+    if (UnityUnits && !Options->Executor.CacheKey.empty())
+    {
+        Options->Executor.CacheKey += "\n--unity-units";
+    }
+
+    if (!Shard.empty() && !parseShard(Shard, &Options->Executor))
+    {
+        return false;
+    }
+
+    if (!Diff.empty() && !Since.empty())
+    {
+        llvm::errs()
+            << "The options ‘--diff’ and ‘--since’ are exclusive.\n";
+        return false;
+    }
+
+    if (!Diff.empty() || !Since.empty())
+    {
+        llvm::Expected<pxr::ChangedRanges> Changes
+            = Diff.empty()
+            ? pxr::ChangedRanges::fromRevision(Since)
+            : pxr::ChangedRanges::fromFile(Diff);
+        if (!Changes)
+        {
+            llvm::errs() << llvm::toString(Changes.takeError()) << "\n";
+            return false;
+        }
+
+        // The cached replacements are the ones left once filtered.
+
+        if (!Options->Executor.CacheKey.empty())
+        {
+            Options->Executor.CacheKey += "\n--changes=" + Changes->getKey();
+        }
+
+        Options->Executor.Changes = std::make_shared<pxr::ChangedRanges>(
+            std::move(*Changes)
+        );
+    }
+
+    // The reports written at the end need all the replacements, and so does
+    // the export. The precompiled headers can't be used anymore once any of
+    // the headers that they were built from is written.
+
+    if (
+        Stream
+        && (
+            !ExportReplacements.empty()
+            || Report == pxr::ReportFormat::Summary
+            || Report == pxr::ReportFormat::JSON
+        )
+    )
+    {
+        llvm::errs()
+            << "The option ‘--stream’ can't be used with "
+            << "‘--export-replacements’ nor with the summary and JSON "
+            << "reports.\n";
+        return false;
+    }
+
+    if (Stream && !PrefixHeader.empty())
+    {
+        llvm::errs()
+            << "The options ‘--stream’ and ‘--prefix-header’ are exclusive.\n";
+        return false;
+    }
+
+    Options->ExportPath = ExportReplacements;
+    Options->Stream = Stream;
+    Options->Report = Report;
+    Options->ReportPath = ReportFile;
+    Options->ServePath = Serve;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "Executor.h"
+#include "Report.h"
+
+#include <llvm/Support/CommandLine.h>
+
+#include <string>
+
+namespace pxr {
+
+struct CommonOptions
+{
+    ExecutorOptions Executor;
+
+    // File to export the replacements to instead of applying them.
+    std::string ExportPath;
+
+    // Apply the replacements of each source as soon as it is processed
+    // rather than all at once at the end.
+    bool Stream = false;
+
+    // How to report the replacements found, and where to for the formats
+    // written once all the files were processed.
+    ReportFormat Report = ReportFormat::Diagnostics;
+    std::string ReportPath;
+
+    // Socket to serve the requests of clients on instead of processing
+    // the files given on the command line.
+    std::string ServePath;
+};
+
+// Make the options shared by all the tools show up in the given category.
+// This must be called before parsing the command line.
+
+void
+addCommonOptions(
+    llvm::cl::OptionCategory &Category
+);
+
+bool
+getCommonOptions(
+    CommonOptions *Options
+);
+
+} // namespace pxr
+
+#endif // OPTIONS_H
@@ -0,0 +1,112 @@
+#include "PreambleCache.h"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendOptions.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Frontend/PrecompiledPreamble.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace pxr {
+
+std::shared_ptr<const clang::PrecompiledPreamble>
+PreambleCache::
+apply(
+    clang::CompilerInvocation *Invocation,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+    std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps
+)
+{
+    const clang::FrontendOptions &FrontendOpts
+        = Invocation->getFrontendOpts();
+    if (
+        FrontendOpts.Inputs.size() != 1
+        || !FrontendOpts.Inputs.front().isFile()
+    )
+    {
+        return nullptr;
+    }
+
+    std::string MainPath = FrontendOpts.Inputs.front().getFile().str();
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = FileSystem->getBufferForFile(MainPath);
+    if (!Buffer)
+    {
+        return nullptr;
+    }
+
+    clang::PreambleBounds Bounds = clang::ComputePreambleBounds(
+        *Invocation->getLangOpts(), **Buffer, 0
+    );
+    if (Bounds.Size == 0)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<const clang::PrecompiledPreamble> Preamble;
+    {
+        std::lock_guard<std::mutex> Lock(this->Mutex);
+        Preamble = this->Preambles.lookup(MainPath);
+    }
+
+    if (
+        !Preamble
+        || !Preamble->CanReuse(
+            *Invocation, **Buffer, Bounds, *FileSystem
+        )
+    )
+    {
+        // The diagnostics of the preamble are reported again when parsing
+        // the source, should it fail to build.
+
+        llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> Diagnostics
+            = clang::CompilerInstance::createDiagnostics(
+                &Invocation->getDiagnosticOpts(),
+                new clang::IgnoringDiagConsumer(),
+                true
+            );
+
+        clang::PreambleCallbacks Callbacks;
+        llvm::ErrorOr<clang::PrecompiledPreamble> Built
+            = clang::PrecompiledPreamble::Build(
+                *Invocation,
+                Buffer->get(),
+                Bounds,
+                *Diagnostics,
+                FileSystem,
+                std::move(PCHContainerOps),
+                false,
+                Callbacks
+            );
+        if (!Built)
+        {
+            return nullptr;
+        }
+
+        Preamble = std::make_shared<const clang::PrecompiledPreamble>(
+            std::move(*Built)
+        );
+
+        std::lock_guard<std::mutex> Lock(this->Mutex);
+        this->Preambles[MainPath] = Preamble;
+    }
+
+    // Preambles stored in temporary files are referred to by their path, so
+    // the file system passed here is left as is.
+
+    Preamble->AddImplicitPreamble(*Invocation, FileSystem, Buffer->get());
+    return Preamble;
+}
+
+} // namespace pxr
@@ -0,0 +1,51 @@
+#ifndef PREAMBLE_CACHE_H
+#define PREAMBLE_CACHE_H
+
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Frontend/PrecompiledPreamble.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <mutex>
+
+namespace pxr {
+
+// Precompiled preambles of the sources, that is of the ‘#include’ directives
+// and comments that they start with, kept in memory across runs.
+//
+// A source parsed again with the same preamble, while none of the headers
+// that it includes changed, only needs to parse what comes after it.
+//
+// Safe to use from multiple threads.
+
+class PreambleCache
+{
+public:
+    // Make the invocation parse the preamble of its main file from
+    // a precompiled one, built on first use and rebuilt whenever it can't be
+    // reused anymore. The returned preamble must be kept alive until
+    // the invocation is done, and is null if it couldn't be built.
+    //
+    // The sources and the headers are read through the given file system,
+    // which is the one of the invocation, and the preambles are written to
+    // temporary files.
+
+    std::shared_ptr<const clang::PrecompiledPreamble>
+    apply(
+        clang::CompilerInvocation *Invocation,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem,
+        std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps
+    );
+
+private:
+    std::mutex Mutex;
+    llvm::StringMap<std::shared_ptr<const clang::PrecompiledPreamble>>
+        Preambles;
+};
+
+} // namespace pxr
+
+#endif // PREAMBLE_CACHE_H
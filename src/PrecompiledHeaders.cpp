@@ -0,0 +1,424 @@
+#include "PrecompiledHeaders.h"
+
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+namespace {
+
+/* Includes                                                        O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Read the ‘#include’ directives found at the beginning of a file, skipping
+// blank lines, comments, and ‘#pragma once’. Return whether the whole file
+// was read, that is whether it contains nothing else.
+
+bool
+readLeadingIncludes(
+    llvm::StringRef Buffer,
+    std::vector<std::string> *Includes
+)
+{
+    llvm::SmallVector<llvm::StringRef> Lines;
+    Buffer.split(Lines, '\n');
+
+    bool InComment = false;
+    for (llvm::StringRef Line : Lines)
+    {
+        Line = Line.trim();
+        if (InComment)
+        {
+            size_t End = Line.find("*/");
+            if (End == llvm::StringRef::npos)
+            {
+                continue;
+            }
+
+            InComment = false;
+            Line = Line.drop_front(End + 2).ltrim();
+        }
+
+        if (Line.startswith("/*"))
+        {
+            size_t End = Line.find("*/", 2);
+            if (End == llvm::StringRef::npos)
+            {
+                InComment = true;
+                continue;
+            }
+
+            Line = Line.drop_front(End + 2).ltrim();
+        }
+
+        if (Line.empty() || Line.startswith("//"))
+        {
+            continue;
+        }
+
+        if (!Line.consume_front("#"))
+        {
+            return false;
+        }
+
+        Line = Line.ltrim();
+        if (Line.consume_front("pragma") && Line.trim() == "once")
+        {
+            continue;
+        }
+
+        if (!Line.consume_front("include"))
+        {
+            return false;
+        }
+
+        Line = Line.ltrim();
+        if (Line.empty() || (Line[0] != '"' && Line[0] != '<'))
+        {
+            return false;
+        }
+
+        size_t End = Line.find(Line[0] == '"' ? '"' : '>', 1);
+        if (End == llvm::StringRef::npos)
+        {
+            return false;
+        }
+
+        Includes->push_back(Line.take_front(End + 1).str());
+    }
+
+    return true;
+}
+
+/* Compile Commands                                                O-(''Q)
+   -------------------------------------------------------------------------- */
+
+std::string
+getAbsolutePath(
+    llvm::StringRef Directory,
+    llvm::StringRef Path
+)
+{
+    llvm::SmallString<256> Out(Path);
+    if (llvm::sys::path::is_relative(Out))
+    {
+        Out.clear();
+        llvm::sys::path::append(Out, Directory, Path);
+    }
+
+    llvm::sys::path::remove_dots(Out, true);
+    return std::string(Out.str());
+}
+
+// Arguments of a compile command without the ones specific to its source,
+// such as the source itself and the output files.
+
+clang::tooling::CommandLineArguments
+getFlags(
+    const clang::tooling::CompileCommand &Command
+)
+{
+    clang::tooling::CommandLineArguments Arguments
+        = clang::tooling::combineAdjusters(
+            clang::tooling::getClangStripOutputAdjuster(),
+            clang::tooling::getClangStripDependencyFileAdjuster()
+        )(Command.CommandLine, Command.Filename);
+
+    std::string Source = getAbsolutePath(Command.Directory, Command.Filename);
+    Arguments.erase(
+        std::remove_if(
+            Arguments.begin() + 1,
+            Arguments.end(),
+            [&Command, &Source](const std::string &Argument)
+            {
+                return getAbsolutePath(Command.Directory, Argument) == Source;
+            }
+        ),
+        Arguments.end()
+    );
+
+    return Arguments;
+}
+
+std::string
+hashFlags(
+    llvm::StringRef PrefixHeader,
+    llvm::StringRef Directory,
+    const clang::tooling::CommandLineArguments &Flags
+)
+{
+    llvm::SHA1 Hasher;
+    Hasher.update(PrefixHeader);
+    Hasher.update(llvm::StringRef("\0", 1));
+    Hasher.update(Directory);
+    for (const std::string &Flag : Flags)
+    {
+        Hasher.update(llvm::StringRef("\0", 1));
+        Hasher.update(Flag);
+    }
+
+    return llvm::toHex(Hasher.final(), true);
+}
+
+/* Building                                                        O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Database returning the same command for any file.
+
+class SingleCommandDatabase
+    : public clang::tooling::CompilationDatabase
+{
+public:
+    explicit SingleCommandDatabase(
+        clang::tooling::CompileCommand Command
+    ) :
+        Command(std::move(Command))
+    {
+    }
+
+    std::vector<clang::tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath
+    ) const override
+    {
+        return {this->Command};
+    }
+
+private:
+    clang::tooling::CompileCommand Command;
+};
+
+class GeneratePCHActionFactory
+    : public clang::tooling::FrontendActionFactory
+{
+public:
+    explicit GeneratePCHActionFactory(
+        std::string OutputPath
+    ) :
+        OutputPath(std::move(OutputPath))
+    {
+    }
+
+    std::unique_ptr<clang::FrontendAction>
+    create() override
+    {
+        return std::make_unique<clang::GeneratePCHAction>();
+    }
+
+    bool
+    runInvocation(
+        std::shared_ptr<clang::CompilerInvocation> Invocation,
+        clang::FileManager *Files,
+        std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+        clang::DiagnosticConsumer *DiagConsumer
+    ) override
+    {
+        Invocation->getFrontendOpts().OutputFile = this->OutputPath;
+        return clang::tooling::FrontendActionFactory::runInvocation(
+            std::move(Invocation),
+            Files,
+            std::move(PCHContainerOps),
+            DiagConsumer
+        );
+    }
+
+private:
+    std::string OutputPath;
+};
+
+} // anonymous namespace
+
+/* Class Implementation                                            O-(''Q)
+   -------------------------------------------------------------------------- */
+
+llvm::Expected<std::unique_ptr<PrecompiledHeaders>>
+PrecompiledHeaders::
+create(
+    llvm::StringRef PrefixHeader,
+    llvm::StringRef Directory,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = FileSystem->getBufferForFile(PrefixHeader);
+    if (!Buffer)
+    {
+        return llvm::createStringError(
+            Buffer.getError(),
+            "Failed reading the prefix header %s: %s.",
+            PrefixHeader.str().c_str(),
+            Buffer.getError().message().c_str()
+        );
+    }
+
+    std::unique_ptr<PrecompiledHeaders> Out(new PrecompiledHeaders());
+    if (
+        !readLeadingIncludes((*Buffer)->getBuffer(), &Out->Includes)
+        || Out->Includes.empty()
+    )
+    {
+        return llvm::createStringError(
+            llvm::inconvertibleErrorCode(),
+            "The prefix header %s must only contain ‘#include’ directives.",
+            PrefixHeader.str().c_str()
+        );
+    }
+
+    if (std::error_code Error = llvm::sys::fs::create_directories(Directory))
+    {
+        return llvm::createStringError(
+            Error,
+            "Failed creating the directory %s: %s.",
+            Directory.str().c_str(),
+            Error.message().c_str()
+        );
+    }
+
+    llvm::SmallString<256> Path(PrefixHeader);
+    llvm::sys::fs::make_absolute(Path);
+    llvm::sys::path::remove_dots(Path, true);
+
+    Out->PrefixHeader = std::string(Path.str());
+    Out->Directory = Directory.str();
+    Out->FileSystem = std::move(FileSystem);
+    return std::move(Out);
+}
+
+std::string
+PrecompiledHeaders::
+find(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath
+)
+{
+    // Each command of a source is parsed with the same arguments adjusters,
+    // so only sources having a single command can share a header.
+
+    std::vector<clang::tooling::CompileCommand> Commands
+        = Compilations.getCompileCommands(SourcePath);
+    if (Commands.size() != 1)
+    {
+        return std::string();
+    }
+
+    const clang::tooling::CompileCommand &Command = Commands.front();
+
+    // Fall back to parsing the source from scratch if it doesn't start with
+    // the same includes as the prefix header.
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = this->FileSystem->getBufferForFile(
+            getAbsolutePath(Command.Directory, Command.Filename)
+        );
+    if (!Buffer)
+    {
+        return std::string();
+    }
+
+    std::vector<std::string> Includes;
+    readLeadingIncludes((*Buffer)->getBuffer(), &Includes);
+    if (
+        Includes.size() < this->Includes.size()
+        || !std::equal(
+            this->Includes.begin(), this->Includes.end(), Includes.begin()
+        )
+    )
+    {
+        return std::string();
+    }
+
+    std::string Key = hashFlags(
+        this->PrefixHeader, Command.Directory, getFlags(Command)
+    );
+
+    llvm::SmallString<256> Path(this->Directory);
+    llvm::sys::path::append(Path, Key + ".pch");
+
+    Header *Entry;
+    {
+        std::lock_guard<std::mutex> Lock(this->Mutex);
+        std::unique_ptr<Header> &Slot = this->Headers[Key];
+        if (!Slot)
+        {
+            Slot = std::make_unique<Header>();
+        }
+
+        Entry = Slot.get();
+    }
+
+    // Headers are rebuilt on each run rather than trusted from a previous one
+    // since the headers that they were built from might have changed since.
+
+    std::lock_guard<std::mutex> Lock(Entry->Mutex);
+    if (!Entry->Built)
+    {
+        Entry->Built = true;
+        Entry->Valid = this->build(Command, Path);
+    }
+
+    return Entry->Valid ? std::string(Path.str()) : std::string();
+}
+
+bool
+PrecompiledHeaders::
+build(
+    const clang::tooling::CompileCommand &Command,
+    llvm::StringRef Path
+)
+{
+    clang::tooling::CompileCommand HeaderCommand;
+    HeaderCommand.Directory = Command.Directory;
+    HeaderCommand.Filename = this->PrefixHeader;
+    HeaderCommand.CommandLine = getFlags(Command);
+    HeaderCommand.CommandLine.push_back("-x");
+    HeaderCommand.CommandLine.push_back("c++-header");
+    HeaderCommand.CommandLine.push_back(this->PrefixHeader);
+    HeaderCommand.Output = Path.str();
+
+    SingleCommandDatabase Compilations(HeaderCommand);
+    clang::tooling::ClangTool Tool(
+        Compilations,
+        {this->PrefixHeader},
+        std::make_shared<clang::PCHContainerOperations>(),
+        this->FileSystem
+    );
+    GeneratePCHActionFactory Factory(Path.str());
+    if (Tool.run(&Factory) != 0)
+    {
+        llvm::errs()
+            << "Failed building the precompiled header "
+            << Path
+            << " with the flags of "
+            << Command.Filename
+            << ", the sources sharing these are parsed from scratch.\n";
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace pxr
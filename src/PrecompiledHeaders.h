@@ -0,0 +1,77 @@
+#ifndef PRECOMPILED_HEADERS_H
+#define PRECOMPILED_HEADERS_H
+
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+// Precompiled headers built from a prefix header made of nothing but
+// ‘#include’ directives, such as the ones that every USD source starts with.
+//
+// A header is built once for each distinct set of compile flags found in
+// the compilation database, and a source is only parsed with it if it starts
+// by including the same headers, in the same order, as the prefix header.
+// Including these first is then the same as having them precompiled.
+
+class PrecompiledHeaders
+{
+public:
+    // The sources and the headers are read through the given file system,
+    // and the precompiled headers are written to the disk.
+
+    static llvm::Expected<std::unique_ptr<PrecompiledHeaders>>
+    create(
+        llvm::StringRef PrefixHeader,
+        llvm::StringRef Directory,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+    );
+
+    // Path to the precompiled header to parse the given source with, or
+    // an empty string if it is to be parsed from scratch. The header is built
+    // on the first request for its compile flags.
+    //
+    // Safe to call from multiple threads.
+
+    std::string
+    find(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath
+    );
+
+private:
+    struct Header
+    {
+        std::mutex Mutex;
+        bool Built = false;
+        bool Valid = false;
+    };
+
+    PrecompiledHeaders() = default;
+
+    bool
+    build(
+        const clang::tooling::CompileCommand &Command,
+        llvm::StringRef Path
+    );
+
+    std::string PrefixHeader;
+    std::string Directory;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem;
+    std::vector<std::string> Includes;
+    std::mutex Mutex;
+    llvm::StringMap<std::unique_ptr<Header>> Headers;
+};
+
+} // namespace pxr
+
+#endif // PRECOMPILED_HEADERS_H
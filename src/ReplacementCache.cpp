@@ -0,0 +1,456 @@
+#include "ReplacementCache.h"
+#include "ReplacementStore.h"
+
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FileUtilities.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+namespace {
+
+std::string
+hashBuffer(
+    llvm::StringRef Buffer
+)
+{
+    llvm::SHA1 Hasher;
+    Hasher.update(Buffer);
+    return llvm::toHex(Hasher.final(), true);
+}
+
+std::string
+getAbsolutePath(
+    llvm::StringRef Directory,
+    llvm::StringRef Path
+)
+{
+    llvm::SmallString<256> Out(Path);
+    if (llvm::sys::path::is_relative(Out))
+    {
+        Out.clear();
+        llvm::sys::path::append(Out, Directory, Path);
+    }
+
+    llvm::sys::path::remove_dots(Out, true);
+    return std::string(Out.str());
+}
+
+// Same as the collector used for ‘-MD’, but system headers are recorded too
+// since they can change with the toolchain while the commands stay the same.
+
+class AllDependencyCollector
+    : public clang::DependencyCollector
+{
+public:
+    bool
+    needSystemDependencies() override
+    {
+        return true;
+    }
+};
+
+} // anonymous namespace
+
+/* Replacement Cache                                               O-(''Q)
+   -------------------------------------------------------------------------- */
+
+ReplacementCache::
+ReplacementCache(
+    std::string Directory,
+    std::string ToolKey,
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+) :
+    Directory(std::move(Directory)),
+    ToolKey(std::move(ToolKey)),
+    FileSystem(std::move(FileSystem))
+{
+}
+
+bool
+ReplacementCache::
+load(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath,
+    ReplacementStore *Store
+)
+{
+    std::string EntryPath = this->getEntryPath(Compilations, SourcePath);
+    if (EntryPath.empty())
+    {
+        return false;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(EntryPath);
+    if (!Buffer)
+    {
+        return false;
+    }
+
+    llvm::Expected<llvm::json::Value> Entry
+        = llvm::json::parse((*Buffer)->getBuffer());
+    if (!Entry)
+    {
+        llvm::consumeError(Entry.takeError());
+        return false;
+    }
+
+    const llvm::json::Object *Object = Entry->getAsObject();
+    if (!Object)
+    {
+        return false;
+    }
+
+    const llvm::json::Array *Dependencies = Object->getArray("dependencies");
+    const llvm::json::Array *Replacements = Object->getArray("replacements");
+    if (!Dependencies || !Replacements)
+    {
+        return false;
+    }
+
+    for (const llvm::json::Value &Value : *Dependencies)
+    {
+        const llvm::json::Object *Dependency = Value.getAsObject();
+        if (!Dependency)
+        {
+            return false;
+        }
+
+        llvm::Optional<llvm::StringRef> Path = Dependency->getString("path");
+        llvm::Optional<llvm::StringRef> Hash = Dependency->getString("hash");
+        if (!Path || !Hash || this->hashFile(*Path) != *Hash)
+        {
+            return false;
+        }
+    }
+
+    // Check that every replacement can be read before adding any of them.
+
+    struct CachedReplacement
+    {
+        llvm::sys::fs::UniqueID FileID;
+        clang::tooling::Replacement Replacement;
+        std::string Label;
+    };
+
+    std::vector<CachedReplacement> Items;
+    for (const llvm::json::Value &Value : *Replacements)
+    {
+        const llvm::json::Object *Replacement = Value.getAsObject();
+        if (!Replacement)
+        {
+            return false;
+        }
+
+        llvm::Optional<llvm::StringRef> Path = Replacement->getString("path");
+        llvm::Optional<int64_t> Offset = Replacement->getInteger("offset");
+        llvm::Optional<int64_t> Length = Replacement->getInteger("length");
+        llvm::Optional<llvm::StringRef> Text = Replacement->getString("text");
+        llvm::Optional<llvm::StringRef> Label
+            = Replacement->getString("label");
+        if (!Path || !Offset || !Length || !Text || !Label)
+        {
+            return false;
+        }
+
+        // Files are identified the same way as through a file manager.
+
+        llvm::ErrorOr<llvm::vfs::Status> Status
+            = this->FileSystem->status(*Path);
+        if (!Status)
+        {
+            return false;
+        }
+
+        Items.push_back(
+            {
+                Status->getUniqueID(),
+                clang::tooling::Replacement(
+                    *Path, unsigned(*Offset), unsigned(*Length), *Text
+                ),
+                Label->str(),
+            }
+        );
+    }
+
+    for (const CachedReplacement &Item : Items)
+    {
+        Store->add(Item.FileID, Item.Replacement, Item.Label);
+    }
+
+    return true;
+}
+
+bool
+ReplacementCache::
+save(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath,
+    llvm::ArrayRef<std::string> Dependencies,
+    const ReplacementStore &Store
+)
+{
+    std::string EntryPath = this->getEntryPath(Compilations, SourcePath);
+    if (EntryPath.empty())
+    {
+        return false;
+    }
+
+    std::vector<clang::tooling::CompileCommand> Commands
+        = Compilations.getCompileCommands(SourcePath);
+    llvm::StringRef Directory
+        = Commands.empty() ? llvm::StringRef() : Commands.front().Directory;
+
+    std::string Buffer;
+    llvm::raw_string_ostream Stream(Buffer);
+    llvm::json::OStream JSON(Stream);
+
+    bool Valid = true;
+    JSON.object(
+        [&]()
+        {
+            JSON.attributeArray(
+                "dependencies",
+                [&]()
+                {
+                    for (const std::string &Dependency : Dependencies)
+                    {
+                        std::string Path
+                            = getAbsolutePath(Directory, Dependency);
+                        std::string Hash = this->hashFile(Path);
+                        if (Hash.empty())
+                        {
+                            Valid = false;
+                            continue;
+                        }
+
+                        JSON.object(
+                            [&]()
+                            {
+                                JSON.attribute("path", Path);
+                                JSON.attribute("hash", Hash);
+                            }
+                        );
+                    }
+                }
+            );
+            JSON.attributeArray(
+                "replacements",
+                [&]()
+                {
+                    Store.forEach(
+                        [&](
+                            const clang::tooling::Replacement &Replacement,
+                            llvm::StringRef Label
+                        )
+                        {
+                            JSON.object(
+                                [&]()
+                                {
+                                    JSON.attribute(
+                                        "path", Replacement.getFilePath()
+                                    );
+                                    JSON.attribute(
+                                        "offset", Replacement.getOffset()
+                                    );
+                                    JSON.attribute(
+                                        "length", Replacement.getLength()
+                                    );
+                                    JSON.attribute(
+                                        "text",
+                                        Replacement.getReplacementText()
+                                    );
+                                    JSON.attribute("label", Label);
+                                }
+                            );
+                        }
+                    );
+                }
+            );
+        }
+    );
+
+    Stream.flush();
+
+    // An entry missing some of its dependencies could be used even after
+    // these changed.
+
+    if (!Valid)
+    {
+        return false;
+    }
+
+    if (
+        std::error_code Error = llvm::sys::fs::create_directories(
+            llvm::sys::path::parent_path(EntryPath)
+        )
+    )
+    {
+        llvm::errs()
+            << "Failed creating the cache directory for "
+            << SourcePath
+            << ": "
+            << Error.message()
+            << ".\n";
+        return false;
+    }
+
+    // Write the entry under a temporary name first so that other processes
+    // sharing the cache never read a partial entry.
+
+    if (
+        llvm::Error Error = llvm::writeFileAtomically(
+            EntryPath + "-%%%%%%%%", EntryPath, Buffer
+        )
+    )
+    {
+        llvm::errs()
+            << "Failed writing the cache entry for "
+            << SourcePath
+            << ": "
+            << llvm::toString(std::move(Error))
+            << ".\n";
+        return false;
+    }
+
+    return true;
+}
+
+std::string
+ReplacementCache::
+getEntryPath(
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef SourcePath
+)
+{
+    std::vector<clang::tooling::CompileCommand> Commands
+        = Compilations.getCompileCommands(SourcePath);
+    if (Commands.empty())
+    {
+        return std::string();
+    }
+
+    std::string SourceHash = this->hashFile(
+        getAbsolutePath(Commands.front().Directory, Commands.front().Filename)
+    );
+    if (SourceHash.empty())
+    {
+        return std::string();
+    }
+
+    llvm::SHA1 Hasher;
+    Hasher.update(this->ToolKey);
+    for (const clang::tooling::CompileCommand &Command : Commands)
+    {
+        Hasher.update(llvm::StringRef("\0", 1));
+        Hasher.update(Command.Directory);
+        for (const std::string &Argument : Command.CommandLine)
+        {
+            Hasher.update(llvm::StringRef("\0", 1));
+            Hasher.update(Argument);
+        }
+    }
+
+    Hasher.update(llvm::StringRef("\0", 1));
+    Hasher.update(SourceHash);
+
+    // Spread the entries across subdirectories to keep these small.
+
+    std::string Key = llvm::toHex(Hasher.final(), true);
+    llvm::SmallString<256> Out(this->Directory);
+    llvm::sys::path::append(
+        Out, llvm::StringRef(Key).take_front(2), Key + ".json"
+    );
+    return std::string(Out.str());
+}
+
+std::string
+ReplacementCache::
+hashFile(
+    llvm::StringRef Path
+)
+{
+    {
+        std::lock_guard<std::mutex> Lock(this->Mutex);
+        auto It = this->FileHashes.find(Path);
+        if (It != this->FileHashes.end())
+        {
+            return It->getValue();
+        }
+    }
+
+    std::string Hash;
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = this->FileSystem->getBufferForFile(Path);
+    if (Buffer)
+    {
+        Hash = hashBuffer((*Buffer)->getBuffer());
+    }
+
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    this->FileHashes[Path] = Hash;
+    return Hash;
+}
+
+/* Dependency Recorder                                             O-(''Q)
+   -------------------------------------------------------------------------- */
+
+bool
+DependencyRecorder::
+handleBeginSource(
+    clang::CompilerInstance &CI
+)
+{
+    if (!this->Collector)
+    {
+        this->Collector = std::make_shared<AllDependencyCollector>();
+    }
+
+    // The preprocessor already exists at this point but the reader of any
+    // precompiled header doesn't, and it picks up the collectors registered
+    // onto the compiler instance when created.
+
+    this->Collector->attachToPreprocessor(CI.getPreprocessor());
+    CI.addDependencyCollector(this->Collector);
+    return true;
+}
+
+std::vector<std::string>
+DependencyRecorder::
+takeDependencies()
+{
+    std::vector<std::string> Out;
+    if (this->Collector)
+    {
+        llvm::ArrayRef<std::string> Dependencies
+            = this->Collector->getDependencies();
+        Out.assign(Dependencies.begin(), Dependencies.end());
+        this->Collector.reset();
+    }
+
+    return Out;
+}
+
+} // namespace pxr
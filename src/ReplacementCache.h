@@ -0,0 +1,111 @@
+#ifndef REPLACEMENT_CACHE_H
+#define REPLACEMENT_CACHE_H
+
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+class ReplacementStore;
+
+// On-disk cache of the replacements found in each source.
+//
+// Entries are looked up by hashing the tool, the compile commands of
+// a source, and its content. Each entry then lists the files that the source
+// depended on when it was parsed along with a hash of their content, and is
+// only used if none of them changed since.
+//
+// Safe to use from multiple threads.
+
+class ReplacementCache
+{
+public:
+    // The tool key identifies the tool and the options affecting the
+    // replacements that it finds. The sources and their dependencies are
+    // read through the given file system, and the entries from the disk.
+
+    ReplacementCache(
+        std::string Directory,
+        std::string ToolKey,
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem
+    );
+
+    // Add the replacements recorded for the given source to the store.
+    // Return whether an up-to-date entry was found.
+
+    bool
+    load(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath,
+        ReplacementStore *Store
+    );
+
+    bool
+    save(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath,
+        llvm::ArrayRef<std::string> Dependencies,
+        const ReplacementStore &Store
+    );
+
+private:
+    // Path of the entry for the given source, or an empty string if the
+    // source can't be read.
+
+    std::string
+    getEntryPath(
+        const clang::tooling::CompilationDatabase &Compilations,
+        llvm::StringRef SourcePath
+    );
+
+    // Hash of a file's content, computed once per run, or an empty string
+    // if the file can't be read.
+
+    std::string
+    hashFile(
+        llvm::StringRef Path
+    );
+
+    std::string Directory;
+    std::string ToolKey;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FileSystem;
+    std::mutex Mutex;
+    llvm::StringMap<std::string> FileHashes;
+};
+
+// Record the files that the sources parsed by a tool depend on, including
+// the system headers and the inputs of any precompiled header.
+
+class DependencyRecorder
+    : public clang::tooling::SourceFileCallbacks
+{
+public:
+    bool
+    handleBeginSource(
+        clang::CompilerInstance &CI
+    ) override;
+
+    // Files recorded since the last call.
+
+    std::vector<std::string>
+    takeDependencies();
+
+private:
+    std::shared_ptr<clang::DependencyCollector> Collector;
+};
+
+} // namespace pxr
+
+#endif // REPLACEMENT_CACHE_H
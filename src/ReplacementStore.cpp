@@ -0,0 +1,329 @@
+#include "ReplacementStore.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem/UniqueID.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+ReplacementStore::Status
+ReplacementStore::
+add(
+    llvm::sys::fs::UniqueID FileID,
+    const clang::tooling::Replacement &Replacement,
+    llvm::StringRef Label
+)
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    return this->addUnlocked(FileID, Replacement, Label);
+}
+
+void
+ReplacementStore::
+addUnresolved(
+    const clang::tooling::Replacement &Replacement,
+    llvm::StringRef Label
+)
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    this->Unresolved.push_back({Replacement, Label.str()});
+}
+
+void
+ReplacementStore::
+merge(
+    const ReplacementStore &Other
+)
+{
+    assert(&Other != this);
+
+    std::map<llvm::sys::fs::UniqueID, File> OtherFiles;
+    std::vector<Conflict> OtherConflicts;
+    std::vector<Entry> OtherUnresolved;
+    {
+        std::lock_guard<std::mutex> Lock(Other.Mutex);
+        OtherFiles = Other.Files;
+        OtherConflicts = Other.Conflicts;
+        OtherUnresolved = Other.Unresolved;
+    }
+
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    for (const auto &IDAndFile : OtherFiles)
+    {
+        for (const auto &OffsetAndEntry : IDAndFile.second.Entries)
+        {
+            this->addUnlocked(
+                IDAndFile.first,
+                OffsetAndEntry.second.Replacement,
+                OffsetAndEntry.second.Label
+            );
+        }
+    }
+
+    this->Conflicts.insert(
+        this->Conflicts.end(), OtherConflicts.begin(), OtherConflicts.end()
+    );
+    this->Unresolved.insert(
+        this->Unresolved.end(), OtherUnresolved.begin(), OtherUnresolved.end()
+    );
+}
+
+void
+ReplacementStore::
+clear()
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    this->Files.clear();
+    this->Conflicts.clear();
+    this->Unresolved.clear();
+}
+
+void
+ReplacementStore::
+setDiagnosticsEnabled(
+    bool Enabled
+)
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    this->DiagnosticsEnabled = Enabled;
+}
+
+bool
+ReplacementStore::
+getDiagnosticsEnabled() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    return this->DiagnosticsEnabled;
+}
+
+void
+ReplacementStore::
+setFilter(
+    std::function<bool(const clang::tooling::Replacement &)> Filter
+)
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    this->Filter = std::move(Filter);
+}
+
+bool
+ReplacementStore::
+empty() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    return (
+        this->Files.empty()
+        && this->Conflicts.empty()
+        && this->Unresolved.empty()
+    );
+}
+
+std::map<std::string, clang::tooling::Replacements>
+ReplacementStore::
+getFileToReplacements() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+
+    std::map<std::string, clang::tooling::Replacements> Out;
+    for (const auto &IDAndFile : this->Files)
+    {
+        clang::tooling::Replacements &Replacements = Out[IDAndFile.second.Path];
+        for (const auto &OffsetAndEntry : IDAndFile.second.Entries)
+        {
+            // Overlaps were already rejected when adding the replacements.
+
+            auto Error = Replacements.add(OffsetAndEntry.second.Replacement);
+            if (Error)
+            {
+                llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+            }
+        }
+    }
+
+    return Out;
+}
+
+std::vector<ReplacementStore::Conflict>
+ReplacementStore::
+getConflicts() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    return this->Conflicts;
+}
+
+std::vector<clang::tooling::Replacement>
+ReplacementStore::
+getUnresolved() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+
+    std::vector<clang::tooling::Replacement> Out;
+    for (const Entry &Entry : this->Unresolved)
+    {
+        Out.push_back(Entry.Replacement);
+    }
+
+    return Out;
+}
+
+void
+ReplacementStore::
+forEach(
+    llvm::function_ref<
+        void(
+            const clang::tooling::Replacement &Replacement,
+            llvm::StringRef Label
+        )
+    > Function
+) const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    for (const auto &IDAndFile : this->Files)
+    {
+        for (const auto &OffsetAndEntry : IDAndFile.second.Entries)
+        {
+            Function(
+                OffsetAndEntry.second.Replacement,
+                OffsetAndEntry.second.Label
+            );
+        }
+    }
+}
+
+std::map<std::string, std::map<std::string, unsigned>>
+ReplacementStore::
+getLabelCounts() const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+
+    std::map<std::string, std::map<std::string, unsigned>> Out;
+    for (const auto &IDAndFile : this->Files)
+    {
+        std::map<std::string, unsigned> &Counts = Out[IDAndFile.second.Path];
+        for (const auto &OffsetAndEntry : IDAndFile.second.Entries)
+        {
+            ++Counts[OffsetAndEntry.second.Label];
+        }
+    }
+
+    return Out;
+}
+
+void
+ReplacementStore::
+reportConflicts(
+    llvm::raw_ostream &Stream
+) const
+{
+    std::lock_guard<std::mutex> Lock(this->Mutex);
+    for (const Conflict &Conflict : this->Conflicts)
+    {
+        Stream
+            << Conflict.Rejected.getFilePath()
+            << ":"
+            << Conflict.Rejected.getOffset()
+            << ": conflicting replacement ‘"
+            << Conflict.Rejected.getReplacementText()
+            << "’ (length "
+            << Conflict.Rejected.getLength()
+            << ") was dropped in favour of ‘"
+            << Conflict.Existing.getReplacementText()
+            << "’ (offset "
+            << Conflict.Existing.getOffset()
+            << ", length "
+            << Conflict.Existing.getLength()
+            << ").\n";
+    }
+
+    for (const Entry &Entry : this->Unresolved)
+    {
+        Stream
+            << Entry.Replacement.getFilePath()
+            << ":"
+            << Entry.Replacement.getOffset()
+            << ": replacement ‘"
+            << Entry.Replacement.getReplacementText()
+            << "’ ("
+            << Entry.Label
+            << ") was dropped since its file couldn't be found.\n";
+    }
+}
+
+ReplacementStore::Status
+ReplacementStore::
+addUnlocked(
+    llvm::sys::fs::UniqueID FileID,
+    const clang::tooling::Replacement &Replacement,
+    llvm::StringRef Label
+)
+{
+    if (this->Filter && !this->Filter(Replacement))
+    {
+        return Status::Filtered;
+    }
+
+    File &File = this->Files[FileID];
+    if (File.Path.empty())
+    {
+        File.Path = Replacement.getFilePath().str();
+    }
+
+    unsigned Offset = Replacement.getOffset();
+    unsigned Length = Replacement.getLength();
+
+    // Look for a replacement starting at the same offset, or overlapping
+    // either with the next or with the previous one.
+
+    auto Next = File.Entries.lower_bound(Offset);
+    if (Next != File.Entries.end())
+    {
+        const clang::tooling::Replacement &Other = Next->second.Replacement;
+        if (Next->first == Offset)
+        {
+            if (
+                Other.getLength() == Length
+                && Other.getReplacementText() == Replacement.getReplacementText()
+            )
+            {
+                return Status::Duplicate;
+            }
+
+            this->Conflicts.push_back({Other, Replacement});
+            return Status::Conflict;
+        }
+
+        if (Next->first < Offset + Length)
+        {
+            this->Conflicts.push_back({Other, Replacement});
+            return Status::Conflict;
+        }
+    }
+
+    if (Next != File.Entries.begin())
+    {
+        const clang::tooling::Replacement &Other
+            = std::prev(Next)->second.Replacement;
+        if (Other.getOffset() + Other.getLength() > Offset)
+        {
+            this->Conflicts.push_back({Other, Replacement});
+            return Status::Conflict;
+        }
+    }
+
+    File.Entries.emplace_hint(Next, Offset, Entry{Replacement, Label.str()});
+    return Status::Added;
+}
+
+} // namespace pxr
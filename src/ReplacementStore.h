@@ -0,0 +1,162 @@
+#ifndef REPLACEMENT_STORE_H
+#define REPLACEMENT_STORE_H
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem/UniqueID.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+// Replacements indexed by file and by offset. Registering a replacement
+// that was already registered is a no-op, and one overlapping with
+// an existing replacement is recorded as a conflict rather than applied.
+// One whose file can't be found is recorded as unresolved, which fails the
+// processing of its source. It is safe to add replacements concurrently.
+
+class ReplacementStore
+{
+public:
+    enum class Status
+    {
+        Added,
+        Duplicate,
+        Conflict,
+        Filtered,
+    };
+
+    struct Conflict
+    {
+        clang::tooling::Replacement Existing;
+        clang::tooling::Replacement Rejected;
+    };
+
+    ReplacementStore() = default;
+
+    ReplacementStore(
+        const ReplacementStore &
+    ) = delete;
+
+    ReplacementStore &
+    operator=(
+        const ReplacementStore &
+    ) = delete;
+
+    Status
+    add(
+        llvm::sys::fs::UniqueID FileID,
+        const clang::tooling::Replacement &Replacement,
+        llvm::StringRef Label
+    );
+
+    void
+    addUnresolved(
+        const clang::tooling::Replacement &Replacement,
+        llvm::StringRef Label
+    );
+
+    // Add all the replacements from another store, in their file and offset
+    // order, followed by its conflicts and its unresolved replacements.
+
+    void
+    merge(
+        const ReplacementStore &Other
+    );
+
+    void
+    clear();
+
+    // Whether registering a replacement also prints a diagnostic describing
+    // it. Stores filled by the workers of an executor inherit this setting.
+
+    void
+    setDiagnosticsEnabled(
+        bool Enabled
+    );
+
+    bool
+    getDiagnosticsEnabled() const;
+
+    // Only keep the replacements for which the given function returns true.
+    // The others are dropped without being checked for conflicts.
+
+    void
+    setFilter(
+        std::function<bool(const clang::tooling::Replacement &)> Filter
+    );
+
+    bool
+    empty() const;
+
+    std::map<std::string, clang::tooling::Replacements>
+    getFileToReplacements() const;
+
+    std::vector<Conflict>
+    getConflicts() const;
+
+    std::vector<clang::tooling::Replacement>
+    getUnresolved() const;
+
+    // Call the given function with each replacement and its label, in their
+    // file and offset order.
+
+    void
+    forEach(
+        llvm::function_ref<
+            void(
+                const clang::tooling::Replacement &Replacement,
+                llvm::StringRef Label
+            )
+        > Function
+    ) const;
+
+    // Number of replacements per file and per label.
+
+    std::map<std::string, std::map<std::string, unsigned>>
+    getLabelCounts() const;
+
+    // Print the conflicts, followed by the unresolved replacements.
+
+    void
+    reportConflicts(
+        llvm::raw_ostream &Stream
+    ) const;
+
+private:
+    struct Entry
+    {
+        clang::tooling::Replacement Replacement;
+        std::string Label;
+    };
+
+    struct File
+    {
+        std::string Path;
+        std::map<unsigned, Entry> Entries;
+    };
+
+    Status
+    addUnlocked(
+        llvm::sys::fs::UniqueID FileID,
+        const clang::tooling::Replacement &Replacement,
+        llvm::StringRef Label
+    );
+
+    mutable std::mutex Mutex;
+    bool DiagnosticsEnabled = true;
+    std::function<bool(const clang::tooling::Replacement &)> Filter;
+    std::map<llvm::sys::fs::UniqueID, File> Files;
+    std::vector<Conflict> Conflicts;
+    std::vector<Entry> Unresolved;
+};
+
+} // namespace pxr
+
+#endif // REPLACEMENT_STORE_H
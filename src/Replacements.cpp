@@ -1,16 +1,16 @@
 #include "Helpers.h"
+#include "ReplacementStore.h"
 #include "Replacements.h"
 
 #include <clang/ASTMatchers/ASTMatchFinder.h>
 #include <clang/Basic/CharInfo.h>
 #include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/FileManager.h>
 #include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
 #include <clang/Tooling/Core/Replacement.h>
-#include <llvm/Support/ErrorHandling.h>
 
 #include <cstdint>
-#include <map>
-#include <string>
 
 namespace {
 
@@ -63,47 +63,37 @@ expandRangeWithBlanks(
 void
 pxr::
 registerReplacement(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     clang::tooling::Replacement Replacement,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
+    clang::SourceLocation Begin,
     clang::SourceLocation Loc,
     const char *Label,
     const clang::FixItHint &Fix
 )
 {
     // Precautions were taken to avoid overlapping matchers but here's an
-    // extra safety to make sure that duplicated work won't be applied.
+    // extra safety to make sure that duplicated work won't be applied, and
+    // that conflicting work gets reported rather than silently applied.
 
-    clang::tooling::Replacements &Replacements
-        = (*FileToReplacements)[std::string(Replacement.getFilePath())];
-    for (auto It = Replacements.begin(); It != Replacements.end(); ++It)
+    const clang::SourceManager &SourceMgr = *Result.SourceManager;
+    const clang::FileEntry *Entry = SourceMgr.getFileEntryForID(
+        SourceMgr.getDecomposedLoc(Begin).first
+    );
+    if (Entry == nullptr)
     {
-        if (
-            (*It).getFilePath() == Replacement.getFilePath()
-            && (*It).getOffset() == Replacement.getOffset()
-        )
-        {
-            if (
-                (*It).getLength() != Replacement.getLength()
-                || (*It).getReplacementText() != Replacement.getReplacementText()
-            )
-            {
-                llvm_unreachable(
-                    "Already existing replacement with different content.\n"
-                );
-            }
-
-            return;
-        }
+        Store->addUnresolved(Replacement, Label);
+        return;
     }
 
-    // Register the replacement within the referenced map object.
-
-    auto Error = Replacements.add(Replacement);
-    if (Error)
+    ReplacementStore::Status Status
+        = Store->add(Entry->getUniqueID(), Replacement, Label);
+    if (
+        Status != ReplacementStore::Status::Added
+        || !Store->getDiagnosticsEnabled()
+    )
     {
-        std::string Msg = llvm::toString(std::move(Error));
-        llvm_unreachable(Msg.c_str());
+        return;
     }
 
     // Print a user-friendly diagnostic to inform about what to expect.
@@ -114,7 +104,7 @@ registerReplacement(
 void
 pxr::
 createInsertion(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     llvm::StringRef Value,
@@ -126,14 +116,14 @@ createInsertion(
     clang::FixItHint Fix
         = clang::FixItHint::CreateInsertion(Loc, Value);
     pxr::registerReplacement(
-        FileToReplacements, Replacement, Result, Loc, Label, Fix
+        Store, Replacement, Result, Loc, Loc, Label, Fix
     );
 }
 
 void
 pxr::
 createReplacement(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceRange Range,
@@ -150,14 +140,20 @@ createReplacement(
     clang::FixItHint Fix
         = clang::FixItHint::CreateReplacement(Range, Value);
     pxr::registerReplacement(
-        FileToReplacements, Replacement, Result, Loc, Label, Fix
+        Store,
+        Replacement,
+        Result,
+        Result.SourceManager->getSpellingLoc(Range.getBegin()),
+        Loc,
+        Label,
+        Fix
     );
 }
 
 void
 pxr::
 createRemoval(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceRange Range,
@@ -181,6 +177,12 @@ createRemoval(
     clang::FixItHint Fix
         = clang::FixItHint::CreateRemoval(Range);
     pxr::registerReplacement(
-        FileToReplacements, Replacement, Result, Loc, Label, Fix
+        Store,
+        Replacement,
+        Result,
+        Result.SourceManager->getSpellingLoc(Range.getBegin()),
+        Loc,
+        Label,
+        Fix
     );
 }
@@ -6,16 +6,19 @@
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Tooling/Core/Replacement.h>
 
-#include <map>
-#include <string>
-
 namespace pxr {
 
+class ReplacementStore;
+
+// Register a replacement starting at the given location, which is the one
+// that the replacement was created from and decides the file it belongs to.
+
 void
 registerReplacement(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     clang::tooling::Replacement Replacement,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
+    clang::SourceLocation Begin,
     clang::SourceLocation Loc,
     const char *Label,
     const clang::FixItHint &Fix
@@ -23,7 +26,7 @@ registerReplacement(
 
 void
 createInsertion(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     llvm::StringRef Value,
@@ -32,7 +35,7 @@ createInsertion(
 
 void
 createReplacement(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceRange Range,
@@ -42,7 +45,7 @@ createReplacement(
 
 void
 createRemoval(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     const clang::ast_matchers::MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceRange Range,
@@ -0,0 +1,358 @@
+#include "Report.h"
+#include "ReplacementStore.h"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+using LabelCounts = std::map<std::string, unsigned>;
+using FileLabelCounts = std::map<std::string, LabelCounts>;
+
+unsigned
+sumCounts(
+    const LabelCounts &Counts
+)
+{
+    unsigned Out = 0;
+    for (const auto &LabelAndCount : Counts)
+    {
+        Out += LabelAndCount.second;
+    }
+
+    return Out;
+}
+
+LabelCounts
+getTotalCounts(
+    const FileLabelCounts &FileCounts
+)
+{
+    LabelCounts Out;
+    for (const auto &FileAndCounts : FileCounts)
+    {
+        for (const auto &LabelAndCount : FileAndCounts.second)
+        {
+            Out[LabelAndCount.first] += LabelAndCount.second;
+        }
+    }
+
+    return Out;
+}
+
+// Matchers sorted from the slowest to the fastest.
+
+std::vector<llvm::StringRef>
+sortMatchers(
+    const llvm::StringMap<llvm::TimeRecord> &MatcherTimes
+)
+{
+    std::vector<llvm::StringRef> Out;
+    for (const auto &It : MatcherTimes)
+    {
+        Out.push_back(It.getKey());
+    }
+
+    std::sort(
+        Out.begin(),
+        Out.end(),
+        [&MatcherTimes](llvm::StringRef A, llvm::StringRef B)
+        {
+            double TimeA = MatcherTimes.lookup(A).getProcessTime();
+            double TimeB = MatcherTimes.lookup(B).getProcessTime();
+            return TimeA != TimeB ? TimeA > TimeB : A < B;
+        }
+    );
+
+    return Out;
+}
+
+void
+writeMatcherTable(
+    llvm::raw_ostream &Stream,
+    const llvm::StringMap<llvm::TimeRecord> &MatcherTimes,
+    const llvm::StringMap<size_t> &MatchCounts
+)
+{
+    double Total = 0.0;
+    for (const auto &It : MatcherTimes)
+    {
+        Total += It.getValue().getProcessTime();
+    }
+
+    // The format objects only take fundamental types and pointers, not the
+    // arrays of the string literals, so the titles are justified instead.
+
+    Stream
+        << llvm::left_justify("Matcher", 24) << " "
+        << llvm::right_justify("Matches", 10) << " "
+        << llvm::right_justify("User (s)", 10) << " "
+        << llvm::right_justify("System (s)", 10) << " "
+        << llvm::right_justify("Wall (s)", 10) << " "
+        << llvm::right_justify("Share", 7) << "\n";
+
+    for (llvm::StringRef Matcher : sortMatchers(MatcherTimes))
+    {
+        const llvm::TimeRecord &Time = MatcherTimes.lookup(Matcher);
+        double Share
+            = Total > 0.0 ? 100.0 * Time.getProcessTime() / Total : 0.0;
+        Stream
+            << llvm::format(
+                "%-24s %10zu %10.3f %10.3f %10.3f %6.1f%%\n",
+                Matcher.str().c_str(),
+                MatchCounts.lookup(Matcher),
+                Time.getUserTime(),
+                Time.getSystemTime(),
+                Time.getWallTime(),
+                Share
+            );
+    }
+}
+
+void
+writeSummary(
+    llvm::raw_ostream &Stream,
+    const FileLabelCounts &FileCounts,
+    const std::vector<pxr::ReplacementStore::Conflict> &Conflicts,
+    const llvm::StringMap<llvm::TimeRecord> *MatcherTimes,
+    const llvm::StringMap<size_t> &MatchCounts
+)
+{
+    LabelCounts TotalCounts = getTotalCounts(FileCounts);
+
+    Stream
+        << sumCounts(TotalCounts)
+        << " replacements in "
+        << FileCounts.size()
+        << " files, "
+        << Conflicts.size()
+        << " conflicts.\n";
+
+    for (const auto &LabelAndCount : TotalCounts)
+    {
+        Stream
+            << "  "
+            << LabelAndCount.second
+            << "\t"
+            << LabelAndCount.first
+            << "\n";
+    }
+
+    for (const auto &FileAndCounts : FileCounts)
+    {
+        Stream
+            << FileAndCounts.first
+            << ": "
+            << sumCounts(FileAndCounts.second)
+            << " replacements.\n";
+
+        for (const auto &LabelAndCount : FileAndCounts.second)
+        {
+            Stream
+                << "  "
+                << LabelAndCount.second
+                << "\t"
+                << LabelAndCount.first
+                << "\n";
+        }
+    }
+
+    if (MatcherTimes)
+    {
+        writeMatcherTable(Stream, *MatcherTimes, MatchCounts);
+    }
+}
+
+void
+writeCounts(
+    llvm::json::OStream &JSON,
+    const LabelCounts &Counts
+)
+{
+    JSON.objectBegin();
+    for (const auto &LabelAndCount : Counts)
+    {
+        JSON.attribute(LabelAndCount.first, LabelAndCount.second);
+    }
+
+    JSON.objectEnd();
+}
+
+void
+writeReplacement(
+    llvm::json::OStream &JSON,
+    const clang::tooling::Replacement &Replacement
+)
+{
+    JSON.object(
+        [&]()
+        {
+            JSON.attribute("offset", Replacement.getOffset());
+            JSON.attribute("length", Replacement.getLength());
+            JSON.attribute("text", Replacement.getReplacementText());
+        }
+    );
+}
+
+void
+writeJSON(
+    llvm::raw_ostream &Stream,
+    const FileLabelCounts &FileCounts,
+    const std::vector<pxr::ReplacementStore::Conflict> &Conflicts,
+    const llvm::StringMap<llvm::TimeRecord> *MatcherTimes,
+    const llvm::StringMap<size_t> &MatchCounts
+)
+{
+    LabelCounts TotalCounts = getTotalCounts(FileCounts);
+
+    llvm::json::OStream JSON(Stream, 2);
+    JSON.objectBegin();
+
+    JSON.attribute("replacements", sumCounts(TotalCounts));
+
+    JSON.attributeBegin("labels");
+    writeCounts(JSON, TotalCounts);
+    JSON.attributeEnd();
+
+    JSON.attributeBegin("files");
+    JSON.objectBegin();
+    for (const auto &FileAndCounts : FileCounts)
+    {
+        JSON.attributeBegin(FileAndCounts.first);
+        writeCounts(JSON, FileAndCounts.second);
+        JSON.attributeEnd();
+    }
+
+    JSON.objectEnd();
+    JSON.attributeEnd();
+
+    JSON.attributeBegin("conflicts");
+    JSON.arrayBegin();
+    for (const pxr::ReplacementStore::Conflict &Conflict : Conflicts)
+    {
+        JSON.object(
+            [&]()
+            {
+                JSON.attribute("file", Conflict.Rejected.getFilePath());
+
+                JSON.attributeBegin("existing");
+                writeReplacement(JSON, Conflict.Existing);
+                JSON.attributeEnd();
+
+                JSON.attributeBegin("rejected");
+                writeReplacement(JSON, Conflict.Rejected);
+                JSON.attributeEnd();
+            }
+        );
+    }
+
+    JSON.arrayEnd();
+    JSON.attributeEnd();
+
+    if (MatcherTimes)
+    {
+        JSON.attributeBegin("matchers");
+        JSON.arrayBegin();
+        for (llvm::StringRef Matcher : sortMatchers(*MatcherTimes))
+        {
+            const llvm::TimeRecord &Time = MatcherTimes->lookup(Matcher);
+            JSON.object(
+                [&]()
+                {
+                    JSON.attribute("name", Matcher);
+                    JSON.attribute("matches", MatchCounts.lookup(Matcher));
+                    JSON.attribute("user", Time.getUserTime());
+                    JSON.attribute("system", Time.getSystemTime());
+                    JSON.attribute("wall", Time.getWallTime());
+                }
+            );
+        }
+
+        JSON.arrayEnd();
+        JSON.attributeEnd();
+    }
+
+    JSON.objectEnd();
+    Stream << "\n";
+}
+
+} // anonymous namespace
+
+bool
+pxr::
+writeReport(
+    llvm::StringRef Path,
+    pxr::ReportFormat Format,
+    const pxr::ReplacementStore &Store,
+    const llvm::StringMap<llvm::TimeRecord> *MatcherTimes,
+    const llvm::StringMap<size_t> *MatchCounts
+)
+{
+    bool HasReport
+        = Format == ReportFormat::Summary || Format == ReportFormat::JSON;
+    if (!HasReport && !MatcherTimes)
+    {
+        return true;
+    }
+
+    std::unique_ptr<llvm::raw_fd_ostream> File;
+    if (!Path.empty() && Path != "-")
+    {
+        std::error_code Error;
+        File = std::make_unique<llvm::raw_fd_ostream>(
+            Path, Error, llvm::sys::fs::OF_Text
+        );
+        if (Error)
+        {
+            llvm::errs()
+                << "Failed writing the report to "
+                << Path
+                << ": "
+                << Error.message()
+                << ".\n";
+            return false;
+        }
+    }
+
+    llvm::raw_ostream &Stream = File ? *File : llvm::outs();
+
+    llvm::StringMap<size_t> NoCounts;
+    if (!MatchCounts)
+    {
+        MatchCounts = &NoCounts;
+    }
+
+    if (!HasReport)
+    {
+        writeMatcherTable(Stream, *MatcherTimes, *MatchCounts);
+        return true;
+    }
+
+    FileLabelCounts FileCounts = Store.getLabelCounts();
+    std::vector<ReplacementStore::Conflict> Conflicts = Store.getConflicts();
+    if (Format == ReportFormat::Summary)
+    {
+        writeSummary(
+            Stream, FileCounts, Conflicts, MatcherTimes, *MatchCounts
+        );
+    }
+    else
+    {
+        writeJSON(Stream, FileCounts, Conflicts, MatcherTimes, *MatchCounts);
+    }
+
+    return true;
+}
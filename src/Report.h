@@ -0,0 +1,46 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Timer.h>
+
+#include <cstddef>
+
+namespace pxr {
+
+class ReplacementStore;
+
+enum class ReportFormat
+{
+    // One diagnostic per replacement, as it gets registered.
+    Diagnostics,
+
+    // Replacement counts per label and per file, in a human-readable form.
+    Summary,
+
+    // Same as the summary, plus the conflicts, as a JSON document.
+    JSON,
+
+    None,
+};
+
+// Write a report of the replacements found in the store, either to the given
+// file or to stdout if the path is empty or ‘-’. The diagnostics format is
+// reported as the replacements are found so nothing is written for it.
+// If matcher times are given, they are appended to the report along with the
+// number of matches of each matcher, or written on their own as a table when
+// there is no report.
+
+bool
+writeReport(
+    llvm::StringRef Path,
+    ReportFormat Format,
+    const ReplacementStore &Store,
+    const llvm::StringMap<llvm::TimeRecord> *MatcherTimes = nullptr,
+    const llvm::StringMap<size_t> *MatchCounts = nullptr
+);
+
+} // namespace pxr
+
+#endif // REPORT_H
@@ -0,0 +1,369 @@
+#include "Server.h"
+#include "Apply.h"
+#include "Executor.h"
+#include "ReplacementStore.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Errno.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+/* Connection                                                      O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Read everything that the client sends until it shuts down its writing side
+// of the connection.
+
+bool
+readAll(
+    int Socket,
+    std::string *Out
+)
+{
+    // The arguments are forwarded as constant references, so the buffer
+    // is given as a pointer rather than as an array that would be constant.
+
+    char Buffer[4096];
+    while (true)
+    {
+        ssize_t Count = llvm::sys::RetryAfterSignal(
+            -1, ::recv, Socket, static_cast<void *>(Buffer), sizeof(Buffer), 0
+        );
+        if (Count < 0)
+        {
+            return false;
+        }
+
+        if (Count == 0)
+        {
+            return true;
+        }
+
+        Out->append(Buffer, size_t(Count));
+    }
+}
+
+bool
+writeAll(
+    int Socket,
+    llvm::StringRef Data
+)
+{
+    // Clients going away while the response is being sent must not bring
+    // the server down with a ‘SIGPIPE’.
+
+    while (!Data.empty())
+    {
+        ssize_t Count = llvm::sys::RetryAfterSignal(
+            -1, ::send, Socket, Data.data(), Data.size(), MSG_NOSIGNAL
+        );
+        if (Count < 0)
+        {
+            return false;
+        }
+
+        Data = Data.drop_front(size_t(Count));
+    }
+
+    return true;
+}
+
+// Whether the path is a socket left over by a server that is gone, that is
+// one that nothing accepts connections on anymore.
+
+bool
+isStaleSocket(
+    llvm::StringRef Path,
+    const sockaddr_un &Address
+)
+{
+    llvm::sys::fs::file_status Status;
+    if (
+        llvm::sys::fs::status(Path, Status, false)
+        || Status.type() != llvm::sys::fs::file_type::socket_file
+    )
+    {
+        return false;
+    }
+
+    int Socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Socket < 0)
+    {
+        return false;
+    }
+
+    int Result = llvm::sys::RetryAfterSignal(
+        -1,
+        ::connect,
+        Socket,
+        reinterpret_cast<const sockaddr *>(&Address),
+        sizeof(Address)
+    );
+    int Error = errno;
+    ::close(Socket);
+    return Result != 0 && Error == ECONNREFUSED;
+}
+
+/* Requests                                                        O-(''Q)
+   -------------------------------------------------------------------------- */
+
+std::string
+formatError(
+    llvm::StringRef Message
+)
+{
+    std::string Out;
+    llvm::raw_string_ostream Stream(Out);
+    llvm::json::OStream JSON(Stream);
+    JSON.object(
+        [&]()
+        {
+            JSON.attribute("status", 1);
+            JSON.attribute("error", Message);
+        }
+    );
+
+    Stream.flush();
+    return Out;
+}
+
+std::string
+formatResponse(
+    int Status,
+    const pxr::ReplacementStore &Store,
+    const std::map<std::string, std::string> &FileToContent
+)
+{
+    std::string Out;
+    llvm::raw_string_ostream Stream(Out);
+    llvm::json::OStream JSON(Stream);
+    JSON.object(
+        [&]()
+        {
+            JSON.attribute("status", Status);
+            JSON.attribute("conflicts", int64_t(Store.getConflicts().size()));
+            JSON.attributeArray(
+                "replacements",
+                [&]()
+                {
+                    Store.forEach(
+                        [&](
+                            const clang::tooling::Replacement &Replacement,
+                            llvm::StringRef Label
+                        )
+                        {
+                            JSON.object(
+                                [&]()
+                                {
+                                    JSON.attribute(
+                                        "path", Replacement.getFilePath()
+                                    );
+                                    JSON.attribute(
+                                        "offset", Replacement.getOffset()
+                                    );
+                                    JSON.attribute(
+                                        "length", Replacement.getLength()
+                                    );
+                                    JSON.attribute(
+                                        "text",
+                                        Replacement.getReplacementText()
+                                    );
+                                    JSON.attribute("label", Label);
+                                }
+                            );
+                        }
+                    );
+                }
+            );
+            JSON.attributeObject(
+                "files",
+                [&]()
+                {
+                    for (const auto &FileAndContent : FileToContent)
+                    {
+                        JSON.attribute(
+                            FileAndContent.first, FileAndContent.second
+                        );
+                    }
+                }
+            );
+        }
+    );
+
+    Stream.flush();
+    return Out;
+}
+
+// Handle a single request and return the response to send back, setting
+// whether the server is to stop.
+
+std::string
+handleRequest(
+    llvm::StringRef Request,
+    pxr::Executor *Executor,
+    bool *Stop
+)
+{
+    llvm::Expected<llvm::json::Value> Value = llvm::json::parse(Request);
+    if (!Value)
+    {
+        return formatError(llvm::toString(Value.takeError()));
+    }
+
+    const llvm::json::Object *Object = Value->getAsObject();
+    if (Object == nullptr)
+    {
+        return formatError("Expected a JSON object.");
+    }
+
+    if (Object->getBoolean("shutdown").getValueOr(false))
+    {
+        *Stop = true;
+        return formatResponse(0, pxr::ReplacementStore(), {});
+    }
+
+    const llvm::json::Array *Files = Object->getArray("files");
+    if (Files == nullptr)
+    {
+        return formatError("Expected a ‘files’ array.");
+    }
+
+    std::vector<std::string> SourcePaths;
+    for (const llvm::json::Value &File : *Files)
+    {
+        llvm::Optional<llvm::StringRef> Path = File.getAsString();
+        if (!Path)
+        {
+            return formatError("Expected the files to be strings.");
+        }
+
+        SourcePaths.push_back(Path->str());
+    }
+
+    // The diagnostics would end up in the server's output rather than in
+    // the client's, which gets the replacements instead.
+
+    pxr::ReplacementStore Store;
+    Store.setDiagnosticsEnabled(false);
+
+    int Status = Executor->run(SourcePaths, &Store);
+
+    std::map<std::string, std::string> FileToContent;
+    if (
+        !pxr::applyReplacements(
+            Store.getFileToReplacements(),
+            *llvm::vfs::getRealFileSystem(),
+            &FileToContent
+        )
+    )
+    {
+        return formatError("Failed applying the replacements.");
+    }
+
+    return formatResponse(Status, Store, FileToContent);
+}
+
+} // anonymous namespace
+
+/* Server                                                          O-(''Q)
+   -------------------------------------------------------------------------- */
+
+int
+pxr::
+serve(
+    llvm::StringRef SocketPath,
+    pxr::Executor *Executor
+)
+{
+    sockaddr_un Address;
+    std::memset(&Address, 0, sizeof(Address));
+    Address.sun_family = AF_UNIX;
+    if (SocketPath.size() >= sizeof(Address.sun_path))
+    {
+        llvm::errs() << "The socket path " << SocketPath << " is too long.\n";
+        return 1;
+    }
+
+    std::memcpy(Address.sun_path, SocketPath.data(), SocketPath.size());
+
+    int Socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Socket < 0)
+    {
+        llvm::errs()
+            << "Failed creating the socket: "
+            << llvm::sys::StrError()
+            << ".\n";
+        return 1;
+    }
+
+    // A socket file left over by a previous server would fail the binding.
+    // Anything else at that path, including the socket of a server still
+    // running, is left alone and fails it instead.
+
+    if (isStaleSocket(SocketPath, Address))
+    {
+        llvm::sys::fs::remove(SocketPath);
+    }
+
+    if (
+        ::bind(Socket, reinterpret_cast<sockaddr *>(&Address), sizeof(Address))
+        || ::listen(Socket, 8)
+    )
+    {
+        llvm::errs()
+            << "Failed listening on the socket "
+            << SocketPath
+            << ": "
+            << llvm::sys::StrError()
+            << ".\n";
+        ::close(Socket);
+        return 1;
+    }
+
+    llvm::errs() << "Listening on " << SocketPath << ".\n";
+
+    bool Stop = false;
+    while (!Stop)
+    {
+        int Connection = llvm::sys::RetryAfterSignal(
+            -1, ::accept, Socket, nullptr, nullptr
+        );
+        if (Connection < 0)
+        {
+            llvm::errs()
+                << "Failed accepting a connection: "
+                << llvm::sys::StrError()
+                << ".\n";
+            break;
+        }
+
+        std::string Request;
+        if (readAll(Connection, &Request))
+        {
+            writeAll(Connection, handleRequest(Request, Executor, &Stop));
+        }
+
+        ::close(Connection);
+    }
+
+    ::close(Socket);
+    llvm::sys::fs::remove(SocketPath);
+    return Stop ? 0 : 1;
+}
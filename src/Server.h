@@ -0,0 +1,41 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <llvm/ADT/StringRef.h>
+
+namespace pxr {
+
+class Executor;
+
+// Serve requests to run the given executor on some files, received on
+// a Unix domain socket, until one asks for the server to stop.
+//
+// The executor, along with the compilation database and the precompiled
+// preambles that it holds, is kept across requests, which saves parsing
+// the headers included by the files again when these are run once more.
+//
+// Each request is a JSON object, sent before shutting down the writing side
+// of the connection:
+//   {"files": ["/path/to/file.cpp", ...]}
+//   {"shutdown": true}
+//
+// And each response is a JSON object holding the replacements found and
+// the resulting content of the files that they apply to:
+//   {
+//     "status": 0,
+//     "conflicts": 0,
+//     "replacements": [
+//       {"path": "...", "offset": 0, "length": 0, "text": "...", "label": "..."}
+//     ],
+//     "files": {"/path/to/file.cpp": "..."}
+//   }
+
+int
+serve(
+    llvm::StringRef SocketPath,
+    Executor *Executor
+);
+
+} // namespace pxr
+
+#endif // SERVER_H
@@ -0,0 +1,85 @@
+#include "StreamingWriter.h"
+#include "Apply.h"
+#include "ReplacementStore.h"
+
+#include <clang/Tooling/Core/Replacement.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace pxr {
+
+StreamingWriter::
+StreamingWriter(
+    llvm::vfs::FileSystem &FileSystem,
+    bool Overwrite,
+    llvm::raw_ostream *Dump
+) :
+    FileSystem(FileSystem),
+    Overwrite(Overwrite),
+    Dump(Dump)
+{
+}
+
+bool
+StreamingWriter::
+write(
+    const ReplacementStore &Result
+)
+{
+    Result.reportConflicts(llvm::errs());
+
+    std::map<std::string, clang::tooling::Replacements> FileToReplacements
+        = Result.getFileToReplacements();
+    for (const auto &FileAndReplaces : FileToReplacements)
+    {
+        if (this->Files.count(FileAndReplaces.first))
+        {
+            llvm::errs()
+                << "Found replacements for the file "
+                << FileAndReplaces.first
+                << " after it was written.\n";
+            return false;
+        }
+    }
+
+    // The content of the files only lives until they are written.
+
+    std::map<std::string, std::string> FileToContent;
+    if (
+        !applyReplacements(FileToReplacements, this->FileSystem, &FileToContent)
+    )
+    {
+        return false;
+    }
+
+    if (this->Dump)
+    {
+        dumpFiles(FileToContent, *this->Dump);
+    }
+
+    if (this->Overwrite && !writeFiles(FileToContent))
+    {
+        return false;
+    }
+
+    for (const auto &FileAndContent : FileToContent)
+    {
+        this->Files.insert(FileAndContent.first);
+    }
+
+    return true;
+}
+
+size_t
+StreamingWriter::
+getFileCount() const
+{
+    return this->Files.size();
+}
+
+} // namespace pxr
@@ -0,0 +1,59 @@
+#ifndef STREAMING_WRITER_H
+#define STREAMING_WRITER_H
+
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstddef>
+
+namespace pxr {
+
+class ReplacementStore;
+
+// Apply and write the replacements of each translation unit as soon as it
+// is processed, and release the content of its files right after, instead
+// of holding the content of all the files until the end.
+//
+// A file only ever gets replacements from the translation unit that has it
+// in scope, so it is final once that translation unit is processed.
+// Replacements for a file that was already written are reported as errors
+// rather than applied.
+//
+// Writing a file doesn't change how the other translation units parse as
+// long as none of them includes it, which holds for sources but not for
+// headers. These can't be among the files given to the executor, which also
+// keeps them from being claimed by the sources including them.
+
+class StreamingWriter
+{
+public:
+    // Write the files if ‘Overwrite’ is set, and dump them to the given
+    // stream if non-null.
+
+    StreamingWriter(
+        llvm::vfs::FileSystem &FileSystem,
+        bool Overwrite,
+        llvm::raw_ostream *Dump
+    );
+
+    bool
+    write(
+        const ReplacementStore &Result
+    );
+
+    // Number of files written so far.
+
+    size_t
+    getFileCount() const;
+
+private:
+    llvm::vfs::FileSystem &FileSystem;
+    bool Overwrite;
+    llvm::raw_ostream *Dump;
+    llvm::StringSet<> Files;
+};
+
+} // namespace pxr
+
+#endif // STREAMING_WRITER_H
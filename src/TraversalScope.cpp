@@ -0,0 +1,106 @@
+#include "TraversalScope.h"
+#include "FileScope.h"
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclBase.h>
+#include <clang/AST/DeclGroup.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class MainFileScopeConsumer
+    : public clang::ASTConsumer
+{
+public:
+    MainFileScopeConsumer(
+        std::unique_ptr<clang::ASTConsumer> Consumer,
+        pxr::FileScope *Scope
+    ) :
+        Consumer(std::move(Consumer)),
+        Scope(Scope)
+    {
+    }
+
+    void
+    Initialize(
+        clang::ASTContext &Context
+    ) override
+    {
+        this->Consumer->Initialize(Context);
+    }
+
+    bool
+    HandleTopLevelDecl(
+        clang::DeclGroupRef Group
+    ) override
+    {
+        return this->Consumer->HandleTopLevelDecl(Group);
+    }
+
+    void
+    HandleTranslationUnit(
+        clang::ASTContext &Context
+    ) override
+    {
+        const clang::SourceManager &SourceMgr = Context.getSourceManager();
+        this->Scope->reset(SourceMgr);
+
+        // Going through the lexical declarations of the translation unit
+        // rather than collecting the ones passed to `HandleTopLevelDecl()`
+        // leaves out the template instantiations. The ones coming from
+        // a precompiled header are never in the main file nor claimed, so
+        // they are not loaded, unless the whole translation unit comes from
+        // an AST file. Headers are claimed here, before any matching happens.
+
+        clang::TranslationUnitDecl *Unit = Context.getTranslationUnitDecl();
+        bool IsLoaded = SourceMgr.isLoadedFileID(SourceMgr.getMainFileID());
+
+        std::vector<clang::Decl *> Decls;
+        for (
+            clang::Decl *Decl
+            : IsLoaded ? Unit->decls() : Unit->noload_decls()
+        )
+        {
+            if (Decl->isImplicit())
+            {
+                continue;
+            }
+
+            clang::SourceLocation Loc
+                = SourceMgr.getExpansionLoc(Decl->getBeginLoc());
+            if (
+                SourceMgr.isInMainFile(Loc)
+                || this->Scope->claim(SourceMgr.getFileID(Loc))
+            )
+            {
+                Decls.push_back(Decl);
+            }
+        }
+
+        Context.setTraversalScope(Decls);
+        this->Consumer->HandleTranslationUnit(Context);
+    }
+
+private:
+    std::unique_ptr<clang::ASTConsumer> Consumer;
+    pxr::FileScope *Scope;
+};
+
+} // anonymous namespace
+
+std::unique_ptr<clang::ASTConsumer>
+pxr::
+newMainFileScopeConsumer(
+    std::unique_ptr<clang::ASTConsumer> Consumer,
+    pxr::FileScope *Scope
+)
+{
+    return std::make_unique<MainFileScopeConsumer>(std::move(Consumer), Scope);
+}
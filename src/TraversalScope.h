@@ -0,0 +1,29 @@
+#ifndef TRAVERSAL_SCOPE_H
+#define TRAVERSAL_SCOPE_H
+
+#include <clang/AST/ASTConsumer.h>
+
+#include <memory>
+
+namespace pxr {
+
+class FileScope;
+
+// Restrict the traversal of the AST done by the given consumer to the
+// top-level declarations of the main file, and of the other files claimed by
+// the translation unit through the given scope, which is reset beforehand.
+//
+// Only these files get refactored but, otherwise, every declaration from
+// every included header would be traversed and rejected one by one. These
+// remain reachable from the main file's nodes, such as with
+// `hasDeclaration()`, but the parent map doesn't cover them anymore.
+
+std::unique_ptr<clang::ASTConsumer>
+newMainFileScopeConsumer(
+    std::unique_ptr<clang::ASTConsumer> Consumer,
+    FileScope *Scope
+);
+
+} // namespace pxr
+
+#endif // TRAVERSAL_SCOPE_H
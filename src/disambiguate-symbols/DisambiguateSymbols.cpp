@@ -4,8 +4,12 @@
 #define DEBUG 0
 
 #include "DisambiguateSymbols.h"
+#include "../FileScope.h"
 #include "../Helpers.h"
+#include "../LexicalFilter.h"
 #include "../Locations.h"
+#include "../MatcherRegistry.h"
+#include "../ReplacementStore.h"
 #include "../Replacements.h"
 
 #include <clang/AST/ASTTypeTraits.h>
@@ -30,7 +34,6 @@
 
 #include <algorithm>
 #include <cassert>
-#include <map>
 #include <string>
 
 using namespace clang::ast_matchers;
@@ -68,13 +71,53 @@ getModuleName(
     return Out;
 }
 
+// File of the anonymous namespace that a match is about, whose module name is
+// the one to give to the namespace. It is the main file unless the namespace
+// is in a header claimed by the translation unit.
+
+clang::FileID
+getAnonNamespaceFileID(
+    const MatchFinder::MatchResult &Result
+)
+{
+    const clang::Decl *Namespace
+        = Result.Nodes.getNodeAs<clang::NamespaceDecl>("anon_namespace");
+    if (!Namespace)
+    {
+        const auto *Member = Result.Nodes.getNodeAs<clang::Decl>("anon_member");
+        for (
+            const clang::DeclContext *Ctx
+                = Member ? Member->getDeclContext() : nullptr;
+            Ctx;
+            Ctx = Ctx->getParent()
+        )
+        {
+            const auto *Decl = llvm::dyn_cast<clang::NamespaceDecl>(Ctx);
+            if (Decl && Decl->isAnonymousNamespace())
+            {
+                Namespace = Decl;
+                break;
+            }
+        }
+    }
+
+    if (!Namespace)
+    {
+        return Result.SourceManager->getMainFileID();
+    }
+
+    return Result.SourceManager->getFileID(
+        Result.SourceManager->getExpansionLoc(Namespace->getLocation())
+    );
+}
 
 /* Fixers                                                          O-(''Q)
    -------------------------------------------------------------------------- */
 
 void
 fixNameAnonNamespace(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
+    const FileScope *Scope,
     const MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceLocation Begin,
@@ -95,15 +138,15 @@ fixNameAnonNamespace(
     Begin = SourceMgr->getSpellingLoc(Begin);
     End = SourceMgr->getSpellingLoc(End);
 
-    // Check whether the location is defined within the current file.
+    // Check whether the location is defined within the files refactored.
 
-    if (SourceMgr->getFileID(Loc) != SourceMgr->getMainFileID())
+    if (!Scope->contains(SourceMgr->getFileID(Loc)))
     {
         return;
     }
 
     pxr::createInsertion(
-        FileToReplacements,
+        Store,
         Result,
         End,
         " " + ModuleName.str(),
@@ -113,7 +156,8 @@ fixNameAnonNamespace(
 
 void
 fixInlineNamespace(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
+    const FileScope *Scope,
     const MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceLocation Begin,
@@ -134,9 +178,9 @@ fixInlineNamespace(
     Begin = SourceMgr->getSpellingLoc(Begin);
     End = SourceMgr->getSpellingLoc(End);
 
-    // Check whether the location is defined within the current file.
+    // Check whether the location is defined within the files refactored.
 
-    if (SourceMgr->getFileID(Loc) != SourceMgr->getMainFileID())
+    if (!Scope->contains(SourceMgr->getFileID(Loc)))
     {
         return;
     }
@@ -147,7 +191,7 @@ fixInlineNamespace(
     if (Buf[0] == ':' && Buf[1] == ':')
     {
         createInsertion(
-            FileToReplacements,
+            Store,
             Result,
             Begin,
             ModuleName,
@@ -157,7 +201,7 @@ fixInlineNamespace(
     }
 
     createInsertion(
-        FileToReplacements,
+        Store,
         Result,
         Begin,
         ModuleName.str() + "::",
@@ -172,25 +216,36 @@ fixInlineNamespace(
 
 DisambiguateSymbolsTool::
 DisambiguateSymbolsTool(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
     llvm::StringRef RootPath
 ) :
-    FileToReplacements(FileToReplacements),
+    Store(Store),
     RootPath(RootPath)
 {
 }
 
+bool
+DisambiguateSymbolsTool::
+mayHaveReplacements(
+    llvm::StringRef Content
+)
+{
+    return containsTokens(Content, {"namespace", "{"});
+}
+
 void
 DisambiguateSymbolsTool::
 registerMatchers(
-    MatchFinder *Finder
+    MatcherRegistry *Registry
 )
 {
+    this->Scope = Registry->getFileScope();
+
     // Anonymous namespaces.
 
     auto AnonNamespace
         = namespaceDecl(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             isAnonymous()
         );
 
@@ -224,7 +279,7 @@ registerMatchers(
                     )
                 )
             )
-        );
+        ).bind("anon_member");
 
     // There are two main categories of AST nodes that we need to match when it
     // comes to finding symbols that reference a declaration belonging into a
@@ -240,7 +295,7 @@ registerMatchers(
 
     auto Expr
         = expr(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             anyOf(
                 declRefExpr(
                     hasDeclaration(Decl)
@@ -263,7 +318,7 @@ registerMatchers(
 
     auto Type
         = typeLoc(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             loc(
                 qualType(
                     hasDeclaration(Decl)
@@ -281,7 +336,7 @@ registerMatchers(
         = nestedNameSpecifierLoc(
             hasAncestor(
                 decl(
-                    isExpansionInMainFile()
+                    isExpansionInFileScope(this->Scope)
                 )
             ),
             specifiesTypeLoc(Type),
@@ -294,7 +349,7 @@ registerMatchers(
 
     auto DeclType
         = decl(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             has(
                 typeLoc(
                     has(
@@ -313,7 +368,8 @@ registerMatchers(
 
     // Matchers.
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "anon_namespace",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             AnonNamespace.bind("anon_namespace")
@@ -321,7 +377,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "expr",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             expr(
@@ -337,7 +394,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "type",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             typeLoc(
@@ -374,7 +432,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "nested",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             nestedNameSpecifierLoc(
@@ -391,7 +450,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "decl_type",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             decl(DeclType)
@@ -406,7 +466,7 @@ run(
     const MatchFinder::MatchResult &Result
 )
 {
-    clang::FileID FileID = Result.SourceManager->getMainFileID();
+    clang::FileID FileID = getAnonNamespaceFileID(Result);
     llvm::Optional<clang::StringRef> FilePath
         = Result.SourceManager->getNonBuiltinFilenameForID(FileID);
     std::string ModuleName = getModuleName(*FilePath, this->RootPath);
@@ -433,7 +493,8 @@ run(
 #endif
 
         fixNameAnonNamespace(
-            this->FileToReplacements,
+            this->Store,
+            this->Scope,
             Result,
             MatchedAnonNamespace->getLocation(),
             Begin,
@@ -497,7 +558,8 @@ run(
 #endif
 
         fixInlineNamespace(
-            this->FileToReplacements,
+            this->Store,
+            this->Scope,
             Result,
             MatchedExpr->getBeginLoc(),
             Begin,
@@ -526,7 +588,8 @@ run(
 #endif
 
         fixInlineNamespace(
-            this->FileToReplacements,
+            this->Store,
+            this->Scope,
             Result,
             MatchedType->getBeginLoc(),
             Begin,
@@ -555,7 +618,8 @@ run(
 #endif
 
         fixInlineNamespace(
-            this->FileToReplacements,
+            this->Store,
+            this->Scope,
             Result,
             MatchedNested->getBeginLoc(),
             Begin,
@@ -3,14 +3,15 @@
 
 #include <clang/AST/DeclCXX.h>
 #include <clang/ASTMatchers/ASTMatchFinder.h>
-#include <clang/Tooling/Core/Replacement.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
 
-#include <map>
-#include <string>
-
 namespace pxr {
+
+class FileScope;
+class MatcherRegistry;
+class ReplacementStore;
+
 namespace disambiguate_symbols {
 
 class DisambiguateSymbolsTool
@@ -18,13 +19,28 @@ class DisambiguateSymbolsTool
 {
 public:
     DisambiguateSymbolsTool(
-        std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+        ReplacementStore *Store,
         llvm::StringRef RootPath
     );
 
+    // Whether the given source could have anything to refactor, as far as
+    // its tokens tell. Only the sources spelling an anonymous namespace
+    // are refactored.
+    //
+    // An anonymous namespace coming from a macro defined in a header is
+    // spelled in that header, where its name would be inserted, so it stays
+    // unnamed when refactoring the sources expanding the macro. Skipping these
+    // sources leaves the references to its members unqualified, as they need
+    // to be. The sources defining such a macro spell the namespace themselves.
+
+    static bool
+    mayHaveReplacements(
+        llvm::StringRef Content
+    );
+
     void
     registerMatchers(
-        clang::ast_matchers::MatchFinder *Finder
+        MatcherRegistry *Registry
     );
 
     void
@@ -33,7 +49,8 @@ public:
     ) override;
 
 private:
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements;
+    ReplacementStore *Store;
+    const FileScope *Scope = nullptr;
     llvm::StringRef RootPath;
 };
 
@@ -1,23 +1,26 @@
 #include "../DisambiguateSymbols.h"
+#include "../../Apply.h"
+#include "../../Executor.h"
+#include "../../Export.h"
+#include "../../MatcherRegistry.h"
+#include "../../Options.h"
+#include "../../ReplacementStore.h"
+#include "../../Report.h"
+#include "../../Server.h"
+#include "../../StreamingWriter.h"
 
 #include <clang/ASTMatchers/ASTMatchers.h>
-#include <clang/Basic/DiagnosticOptions.h>
-#include <clang/Basic/Diagnostic.h>
-#include <clang/Basic/DiagnosticIDs.h>
-#include <clang/Basic/FileManager.h>
-#include <clang/Basic/LangOptions.h>
-#include <clang/Basic/SourceManager.h>
-#include <clang/Frontend/TextDiagnosticPrinter.h>
-#include <clang/Rewrite/Core/Rewriter.h>
 #include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/Core/Replacement.h>
 #include <clang/Tooling/Tooling.h>
-#include <clang/Tooling/Refactoring.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Signals.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <map>
 #include <memory>
 #include <string>
 
@@ -52,9 +55,12 @@ main(
 )
 {
     llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+    pxr::addCommonOptions(DisambiguateSymbolsCategory);
+
+    // No files are needed on the command line when serving these.
 
     auto ExpectedParser = clang::tooling::CommonOptionsParser::create(
-        argc, argv, DisambiguateSymbolsCategory
+        argc, argv, DisambiguateSymbolsCategory, llvm::cl::ZeroOrMore
     );
     if (!ExpectedParser)
     {
@@ -64,79 +70,139 @@ main(
 
     clang::tooling::CommonOptionsParser &OptionsParser = ExpectedParser.get();
 
-    clang::tooling::RefactoringTool Tool(
-        OptionsParser.getCompilations(), OptionsParser.getSourcePathList()
-    );
+    pxr::CommonOptions CommonOptions;
+    if (!pxr::getCommonOptions(&CommonOptions))
+    {
+        return 1;
+    }
+
+    // The tool fixes the symbols of anonymous namespaces clashing once the
+    // sources are compiled together, so these sources can't be parsed from
+    // within a unity unit in the first place.
+
+    if (CommonOptions.Executor.UnityUnits)
+    {
+        llvm::errs() << "Unity units can't be disambiguated.\n";
+        return 1;
+    }
 
-    pxr::disambiguate_symbols::DisambiguateSymbolsTool PxrTool(
-        &Tool.getReplacements(), Root
+    // The cached replacements also depend on the options of the tool.
+
+    CommonOptions.Executor.CacheKey += "\n--root=" + Root;
+
+    pxr::Executor Executor(
+        OptionsParser.getCompilations(),
+        [](
+            pxr::ReplacementStore *Store,
+            pxr::MatcherRegistry *Registry
+        )
+        {
+            auto PxrTool
+                = std::make_unique<pxr::disambiguate_symbols::DisambiguateSymbolsTool>(
+                    Store, Root
+                );
+            PxrTool->registerMatchers(Registry);
+            return PxrTool;
+        },
+        CommonOptions.Executor
     );
 
-    clang::ast_matchers::MatchFinder Finder;
-    PxrTool.registerMatchers(&Finder);
-    std::unique_ptr<clang::tooling::FrontendActionFactory> Factory =
-        clang::tooling::newFrontendActionFactory(&Finder);
+    Executor.setLexicalFilter(
+        pxr::disambiguate_symbols::DisambiguateSymbolsTool::mayHaveReplacements
+    );
 
-    if (int Result = Tool.run(Factory.get()))
+    if (!CommonOptions.ServePath.empty())
     {
-        return Result;
+        return pxr::serve(CommonOptions.ServePath, &Executor);
     }
 
-    clang::LangOptions DefaultLangOptions;
-    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> DiagOpts
-        = new clang::DiagnosticOptions();
-    clang::TextDiagnosticPrinter DiagnosticPrinter(llvm::errs(), &*DiagOpts);
-    clang::DiagnosticsEngine Diagnostics(
-        llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(
-            new clang::DiagnosticIDs()
-        ),
-        &*DiagOpts,
-        &DiagnosticPrinter,
-        false
+    pxr::ReplacementStore Store;
+    Store.setDiagnosticsEnabled(
+        CommonOptions.Report == pxr::ReportFormat::Diagnostics
     );
 
-    clang::FileManager &FileMgr(Tool.getFiles());
-    clang::SourceManager SourceMgr(Diagnostics, FileMgr);
-    clang::Rewriter Rewrite(SourceMgr, DefaultLangOptions);
+    // Write each file as soon as the source having it in scope is processed
+    // rather than once all the sources are.
 
-    std::map<std::string, clang::tooling::Replacements> GroupedReplacements
-        = clang::tooling::groupReplacementsByFile(
-            Rewrite.getSourceMgr().getFileManager(), Tool.getReplacements()
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> RealFileSystem
+        = llvm::vfs::getRealFileSystem();
+    pxr::StreamingWriter Writer(
+        *RealFileSystem, Overwrite, Dump ? &llvm::outs() : nullptr
+    );
+    if (CommonOptions.Stream)
+    {
+        Executor.setResultSink(
+            [&Writer](const pxr::ReplacementStore &Result)
+            {
+                return Writer.write(Result);
+            }
         );
-    for (const auto &FileAndReplaces: GroupedReplacements)
+    }
+
+    if (int Result = Executor.run(OptionsParser.getSourcePathList(), &Store))
     {
-        const clang::tooling::Replacements &Replaces = FileAndReplaces.second;
-        if (!clang::tooling::applyAllReplacements(Replaces, Rewrite))
+        return Result;
+    }
+
+    Store.reportConflicts(llvm::errs());
+    if (
+        !pxr::writeReport(
+            CommonOptions.ReportPath,
+            CommonOptions.Report,
+            Store,
+            CommonOptions.Executor.ProfileMatchers
+                ? &Executor.getMatcherTimes()
+                : nullptr,
+            CommonOptions.Executor.ProfileMatchers
+                ? &Executor.getMatchCounts()
+                : nullptr
+        )
+    )
+    {
+        return 1;
+    }
+
+    if (CommonOptions.Stream)
+    {
+        return 0;
+    }
+
+    std::map<std::string, clang::tooling::Replacements> FileToReplacements
+        = Store.getFileToReplacements();
+
+    // Leave it to an external step to merge and apply the replacements.
+
+    if (!CommonOptions.ExportPath.empty())
+    {
+        if (
+            !pxr::exportReplacements(
+                CommonOptions.ExportPath, "", FileToReplacements
+            )
+        )
         {
-            const std::string &FilePath = FileAndReplaces.first;
-            llvm::errs()
-                << "Failed applying replacements for file "
-                << FilePath.c_str()
-                << ".\n";
             return 1;
         }
+
+        return 0;
+    }
+
+    std::map<std::string, std::string> FileToContent;
+    if (
+        !pxr::applyReplacements(
+            FileToReplacements, *llvm::vfs::getRealFileSystem(), &FileToContent
+        )
+    )
+    {
+        return 1;
     }
 
     if (Dump)
     {
-        for (const auto &it : Tool.getReplacements())
-        {
-            llvm::StringRef File = it.first;
-            const llvm::ErrorOr<const clang::FileEntry *> Entry
-                = FileMgr.getFile(File);
-
-            clang::FileID ID
-                = SourceMgr.getOrCreateFileID(*Entry, clang::SrcMgr::C_User);
-            llvm::outs() << "============== " << File << " ==============\n";
-            Rewrite.getEditBuffer(ID).write(llvm::outs());
-            llvm::outs() << "\n============================================\n";
-        }
+        pxr::dumpFiles(FileToContent, llvm::outs());
     }
 
-    if (Overwrite && Rewrite.overwriteChangedFiles())
+    if (Overwrite && !pxr::writeFiles(FileToContent))
     {
-        llvm::errs()
-            << "Failed writing the changes to the files.\n";
         return 1;
     }
 
@@ -7,8 +7,15 @@
 #define DEBUG 0
 
 #include "InlineNamespaces.h"
+#include "NamespacePolicy.h"
+#include "UsingIndex.h"
+#include "../FilePattern.h"
+#include "../FileScope.h"
 #include "../Helpers.h"
 #include "../Locations.h"
+#include "../MatcherRegistry.h"
+#include "../Matchers.h"
+#include "../ReplacementStore.h"
 #include "../Replacements.h"
 
 #include <clang/AST/ASTTypeTraits.h>
@@ -20,10 +27,13 @@
 #include <clang/ASTMatchers/ASTMatchFinder.h>
 #include <clang/ASTMatchers/ASTMatchers.h>
 #include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/FileManager.h>
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Basic/SourceManager.h>
 #include <clang/Basic/TokenKinds.h>
 #include <clang/Lex/Lexer.h>
+#include <llvm/ADT/None.h>
+#include <llvm/ADT/Optional.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/StringRef.h>
@@ -31,8 +41,8 @@
 #include <llvm/Support/ErrorHandling.h>
 
 #include <algorithm>
-#include <map>
 #include <string>
+#include <utility>
 
 using namespace clang::ast_matchers;
 
@@ -102,65 +112,93 @@ joinPartialNamespace(
     return llvm::join(Begin, End, "::");
 }
 
-bool
-filterNamespace(
-    llvm::SmallVector<llvm::StringRef> Namespace
+/* Usings                                                          O-(''Q)
+   -------------------------------------------------------------------------- */
+
+clang::NestedNameSpecifierLoc
+getUsingQualifierLoc(
+    const clang::Decl *Using
 )
 {
-    return (
+    switch (Using->getKind())
+    {
+        case clang::Decl::Kind::NamespaceAlias:
+        {
+            return llvm::cast<clang::NamespaceAliasDecl>(Using)
+                ->getQualifierLoc();
+        }
+        case clang::Decl::Kind::Using:
+        {
+            return llvm::cast<clang::UsingDecl>(Using)->getQualifierLoc();
+        }
+        case clang::Decl::Kind::UsingDirective:
+        {
+            return llvm::cast<clang::UsingDirectiveDecl>(Using)
+                ->getQualifierLoc();
+        }
+        default:
+        {
+            return clang::NestedNameSpecifierLoc();
+        }
+    }
+}
 
-        // Only consider inlining some specific namespaces...
+// Namespace spelled by the given ‘using’ declaration, directive, or namespace
+// alias, which is what decides whether it gets removed.
 
-        (
-            Namespace[0] != "boost"
-            && Namespace[0] != "std"
-        )
+llvm::Optional<llvm::SmallVector<llvm::StringRef>>
+getUsingNamespace(
+    const MatchFinder::MatchResult &Result,
+    const clang::Decl *Using,
+    clang::NestedNameSpecifierLoc Nested
+)
+{
+    // Retrieve the source range matching the full namespace.
 
-        // ... with a few exceptions.
+    llvm::Optional<clang::Token> EndToken
+        = clang::Lexer::findNextToken(
+            Using->getEndLoc(),
+            *Result.SourceManager,
+            Result.Context->getLangOpts()
+        );
 
-        || (
-            Namespace[0] == "boost"
-            && Namespace.size() > 1
-            && (
-                Namespace[1] == "hash_value"
-            )
-        )
-        || (
-            Namespace[0] == "std"
-            && Namespace.size() > 1
-            && (
-                Namespace[1] == "chrono_literals"
-                || Namespace[1] == "swap"
-            )
-        )
-    );
-}
+    if (!EndToken)
+    {
+        return llvm::None;
+    }
 
-bool
-filterSymbol(
-    llvm::SmallVector<llvm::StringRef> Namespace,
-    llvm::StringRef SymbolName
-)
-{
-    return (
-        Namespace[0] == "std"
-        && SymbolName == "swap"
-    );
+    clang::SourceLocation NamespaceBegin = Nested.getBeginLoc();
+    clang::SourceLocation NamespaceEnd = EndToken->getLocation();
+
+    if (!NamespaceBegin.isValid())
+    {
+        NamespaceBegin = Using->getLocation();
+    }
+
+    // Retrieve the actual namespace value.
+
+    return splitNamespace(getSourceChars(Result, NamespaceBegin, NamespaceEnd));
 }
 
-void
-shortenDeclNamespace(
-    llvm::SmallVector<llvm::StringRef> &Namespace,
+// Whether the given ‘using’ declaration, directive, or namespace alias gets
+// removed, in which case it can't be relied upon to shorten the references.
+
+bool
+isRemovedUsing(
+    const FileScope *Scope,
+    const NamespacePolicy &Policy,
     const MatchFinder::MatchResult &Result,
-    const clang::DeclContext *Context,
-    clang::SourceLocation Loc,
-    const llvm::SmallVector<const clang::NamespaceAliasDecl *> &NamespaceAliasDeps,
-    const llvm::SmallVector<const clang::UsingDecl *> &UsingDeps,
-    const llvm::SmallVector<const clang::UsingDirectiveDecl *> &UsingNamespaceDeps
+    const clang::Decl *Using
 )
 {
-    // TODO: avoid hardcoding workarounds for ‘boost::python::object’,
-    //       ‘boost::iterators’, ‘boost::operators_impl’, and others.
+    if (!Scope->containsExpansion(Using->getBeginLoc()))
+    {
+        return false;
+    }
+
+    llvm::Optional<llvm::SmallVector<llvm::StringRef>> Namespace
+        = getUsingNamespace(Result, Using, getUsingQualifierLoc(Using));
+    return Namespace && !Policy.lookup(*Namespace).Kept;
 }
 
 /* Fixers                                                          O-(''Q)
@@ -168,7 +206,8 @@ shortenDeclNamespace(
 
 void
 fixRemoveUsingNamespace(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
+    ReplacementStore *Store,
+    const NamespacePolicy &Policy,
     const MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceLocation Begin,
@@ -189,36 +228,11 @@ fixRemoveUsingNamespace(
     Begin = SourceMgr->getSpellingLoc(Begin);
     End = SourceMgr->getSpellingLoc(End);
 
-    // Retrieve the source range matching the full namespace.
-
-    llvm::Optional<clang::Token> EndToken
-        = clang::Lexer::findNextToken(
-            MatchedUsing->getEndLoc(),
-            *Result.SourceManager,
-            Result.Context->getLangOpts()
-        );
-
-    if (!EndToken)
-    {
-        return;
-    }
-
-    clang::SourceLocation NamespaceBegin = Nested.getBeginLoc();
-    clang::SourceLocation NamespaceEnd = EndToken->getLocation();
-
-    if (!NamespaceBegin.isValid())
-    {
-        NamespaceBegin = MatchedUsing->getLocation();
-    }
-
-    // Retrieve the actual namespace value.
-
-    llvm::SmallVector<llvm::StringRef> Namespace
-        = splitNamespace(getSourceChars(Result, NamespaceBegin, NamespaceEnd));
-
-    // Filter it.
+    // Retrieve the actual namespace value, and filter it.
 
-    if (filterNamespace(Namespace))
+    llvm::Optional<llvm::SmallVector<llvm::StringRef>> Namespace
+        = getUsingNamespace(Result, MatchedUsing, Nested);
+    if (!Namespace || Policy.lookup(*Namespace).Kept)
     {
         return;
     }
@@ -226,7 +240,7 @@ fixRemoveUsingNamespace(
     // Apply the changes.
 
     createRemoval(
-        FileToReplacements,
+        Store,
         Result,
         Begin,
         clang::SourceRange(Begin, End),
@@ -236,10 +250,10 @@ fixRemoveUsingNamespace(
 
 void
 fixInlineNamespace(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
-    const llvm::SmallVector<const clang::NamespaceAliasDecl *> &NamespaceAliasDeps,
-    const llvm::SmallVector<const clang::UsingDecl *> &UsingDeps,
-    const llvm::SmallVector<const clang::UsingDirectiveDecl *> &UsingNamespaceDeps,
+    ReplacementStore *Store,
+    const FileScope *Scope,
+    const NamespacePolicy &Policy,
+    const UsingIndex &Usings,
     const MatchFinder::MatchResult &Result,
     clang::SourceLocation Loc,
     clang::SourceLocation Begin,
@@ -256,45 +270,47 @@ fixInlineNamespace(
         return;
     }
 
+    // The ‘using’ declarations are visible from where the reference expands.
+
+    clang::SourceLocation RefLoc = SourceMgr->getExpansionLoc(Loc);
+
     // Ensure that the locations refer to where they were spelled in the source.
 
     Loc = SourceMgr->getSpellingLoc(Loc);
     Begin = SourceMgr->getSpellingLoc(Begin);
     End = SourceMgr->getSpellingLoc(End);
 
-    // Check whether the location is defined within the current file.
+    // Check whether the location is defined within the files refactored.
 
-    if (SourceMgr->getFileID(Loc) != SourceMgr->getMainFileID())
+    if (!Scope->contains(SourceMgr->getFileID(Loc)))
     {
         return;
     }
 
-    // Retrieve the reference's context.
+    // Retrieve the reference's context. The declaration enclosing a reference
+    // from within a function body is the function itself, which is also where
+    // the ‘using’ declarations of that body are declared.
 
-    const clang::DeclContext *RefContext
-        = MatchedContext ? MatchedContext->getDeclContext() : nullptr;
+    const clang::DeclContext *RefContext = nullptr;
+    if (MatchedContext)
+    {
+        RefContext = llvm::dyn_cast<clang::DeclContext>(MatchedContext);
+        if (!RefContext)
+        {
+            RefContext = MatchedContext->getDeclContext();
+        }
+    }
 
     // Retrieve the declaration's namespace.
 
     llvm::SmallVector<llvm::StringRef> DeclNamespace
         = buildNamespace(MatchedNamespace);
-    shortenDeclNamespace(
-        DeclNamespace,
-        Result,
-        RefContext,
-        Loc,
-        NamespaceAliasDeps,
-        UsingDeps,
-        UsingNamespaceDeps
-    );
     assert(!DeclNamespace.empty());
 
     // Filter namespaces.
 
-    if (
-        filterNamespace(DeclNamespace)
-        || filterSymbol(DeclNamespace, SymbolName)
-    )
+    NamespacePolicy::Lookup Policed = Policy.lookup(DeclNamespace, SymbolName);
+    if (Policed.Kept)
     {
         return;
     }
@@ -321,49 +337,10 @@ fixInlineNamespace(
 #endif
 
     size_t DeclBeginPos = 0;
-    size_t DeclEndPos = DeclNamespace.size();
 
-    // Strip to the right any undesired namespace.
-    // TODO: instead of hardcoding some namespaces to lookup, implement this
-    //       more procedurally in `shortenDeclNamespace()`.
+    // Strip to the right any hoisted namespace.
 
-    for (size_t I = DeclEndPos; I > DeclBeginPos; --I)
-    {
-        if (
-            DeclNamespace[I - 1].startswith("__")
-            || (
-                DeclNamespace[I - 1] == "operators_impl"
-                && I > 1
-                && DeclNamespace[I - 2] == "boost"
-            )
-            || (
-                DeclNamespace[I - 1] == "iterators"
-                && I > 1
-                && DeclNamespace[I - 2] == "boost"
-            )
-            || (
-                DeclNamespace[I - 1] == "api"
-                && I > 2
-                && DeclNamespace[I - 2] == "python"
-                && DeclNamespace[I - 3] == "boost"
-                && SymbolName == "object"
-            )
-            || (
-                DeclNamespace[I - 1] == "self_ns"
-                && I > 2
-                && DeclNamespace[I - 2] == "python"
-                && DeclNamespace[I - 3] == "boost"
-                && (
-                    SymbolName == "self"
-                    || SymbolName == "self_t"
-                )
-            )
-        )
-        {
-            DeclEndPos = I - 1;
-            break;
-        }
-    }
+    size_t DeclEndPos = Policed.Size;
 
     // Figure out which parts are needed for the referenced namespace to match
     // the one that is declared.
@@ -415,7 +392,28 @@ fixInlineNamespace(
         }
     }
 
-    if (DeclBeginPos >= DeclEndPos)
+    // See if the ‘using’ declarations and the namespace aliases left in place
+    // can shorten them further.
+
+    Shortening Shortened = Usings.find(
+        *SourceMgr, RefContext, RefLoc, MatchedNamespace, SymbolName
+    );
+
+    llvm::StringRef Alias;
+    if (
+        Shortened.Count <= DeclEndPos
+        && Shortened.Count > DeclBeginPos + (Shortened.Alias.empty() ? 0 : 1)
+    )
+    {
+        DeclBeginPos = Shortened.Count;
+        Alias = Shortened.Alias;
+    }
+    else if (Shortened.Count > DeclEndPos && Shortened.Alias.empty())
+    {
+        return;
+    }
+
+    if (DeclBeginPos >= DeclEndPos && Alias.empty())
     {
         return;
     }
@@ -425,14 +423,33 @@ fixInlineNamespace(
     std::string Namespace = joinPartialNamespace(
         DeclNamespace.begin() + DeclBeginPos, DeclNamespace.begin() + DeclEndPos
     );
+    if (!Alias.empty())
+    {
+        Namespace = DeclBeginPos < DeclEndPos
+            ? Alias.str() + "::" + Namespace
+            : Alias.str();
+    }
+
     Namespace += "::";
 
+    // The reference might already go through the alias.
+
+    if (
+        RefEndPos > 0
+        && Namespace == joinPartialNamespace(
+            RefNamespace.begin(), RefNamespace.begin() + RefEndPos
+        ) + "::"
+    )
+    {
+        return;
+    }
+
     // Prepend the new namespace onto the one already existing.
 
     if (RefEndPos == 0)
     {
         createInsertion(
-            FileToReplacements, Result, Begin, Namespace, "inline namespace"
+            Store, Result, Begin, Namespace, "inline namespace"
         );
         return;
     }
@@ -451,7 +468,7 @@ fixInlineNamespace(
 
     assert(Length > 0);
     createReplacement(
-        FileToReplacements,
+        Store,
         Result,
         Begin,
         clang::SourceRange(Begin, Begin.getLocWithOffset(Length - 1)),
@@ -467,25 +484,29 @@ fixInlineNamespace(
 
 InlineNamespacesTool::
 InlineNamespacesTool(
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
-    llvm::StringRef FilePattern
+    ReplacementStore *Store,
+    FilePattern Pattern,
+    NamespacePolicy Policy
 ) :
-    FileToReplacements(FileToReplacements),
-    FilePattern(FilePattern)
+    Store(Store),
+    Pattern(std::move(Pattern)),
+    Policy(std::move(Policy))
 {
 }
 
 void
 InlineNamespacesTool::
 registerMatchers(
-    MatchFinder *Finder
+    MatcherRegistry *Registry
 )
 {
+    this->Scope = Registry->getFileScope();
+
     // Match all the ‘using’ directives to be removed.
 
     auto Using
         = decl(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             anyOf(
                 namespaceAliasDecl(),
                 usingDecl(),
@@ -493,11 +514,13 @@ registerMatchers(
             )
         );
 
-    // Declarations referred by expressions and types.
+    // Declarations referred by expressions and types. These are mostly
+    // declared in headers, which are out of the traversal scope, hence
+    // their namespace is looked up through their lexical contexts.
 
     auto Decl
         = namedDecl(
-            hasAncestor(
+            hasLexicalAncestor(
                 namespaceDecl().bind("namespace")
             ),
             unless(
@@ -525,7 +548,7 @@ registerMatchers(
 
     auto Expr
         = expr(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             anyOf(
                 declRefExpr(
                     hasDeclaration(Decl.bind("decl"))
@@ -557,7 +580,7 @@ registerMatchers(
 
     auto Type
         = typeLoc(
-            isExpansionInMainFile(),
+            isExpansionInFileScope(this->Scope),
             loc(
                 qualType(
                     hasDeclaration(Decl.bind("decl"))
@@ -585,7 +608,7 @@ registerMatchers(
         = nestedNameSpecifierLoc(
             hasAncestor(
                 decl(
-                    isExpansionInMainFile()
+                    isExpansionInFileScope(this->Scope)
                 )
             ),
             specifiesTypeLoc(
@@ -601,7 +624,8 @@ registerMatchers(
     // Matchers to record ‘using’, ‘namespace’, and ‘namespace alias’
     // declarations that can be used to shorten some namespace specifiers.
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "namespace_alias_dep",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             namespaceAliasDecl().bind("namespace_alias_dep")
@@ -609,7 +633,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "using_dep",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             usingDecl().bind("using_dep")
@@ -617,7 +642,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "using_namespace_dep",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             usingDirectiveDecl().bind("using_namespace_dep")
@@ -627,7 +653,8 @@ registerMatchers(
 
     // Matchers.
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "using",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             Using.bind("using")
@@ -635,7 +662,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "expr",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             expr(
@@ -651,7 +679,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "type",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             typeLoc(
@@ -688,7 +717,8 @@ registerMatchers(
         this
     );
 
-    Finder->addMatcher(
+    Registry->addMatcher(
+        "nested",
         traverse(
             clang::TK_IgnoreUnlessSpelledInSource,
             nestedNameSpecifierLoc(
@@ -715,6 +745,29 @@ run(
     const MatchFinder::MatchResult &Result
 )
 {
+    // Only the files in scope get refactored, so there is nothing to do if
+    // none of them belongs to the project. With unity units, the main file
+    // is a generated one, but the sources that it includes are in scope.
+
+    if (!this->hasProjectFiles(*Result.SourceManager))
+    {
+        return;
+    }
+
+    // Most of the declarations referenced are within namespaces that are not
+    // to be inlined, so these are discarded before doing any further work.
+
+    if (
+        const auto *MatchedNamespace
+            = Result.Nodes.getNodeAs<clang::NamespaceDecl>("namespace")
+    )
+    {
+        if (this->isFilteredNamespace(MatchedNamespace))
+        {
+            return;
+        }
+    }
+
     if (
         const auto *MatchedNamespaceAliasDep
             = Result.Nodes.getNodeAs<clang::NamespaceAliasDecl>(
@@ -722,7 +775,7 @@ run(
             )
         )
     {
-        this->NamespaceAliasDeps.push_back(MatchedNamespaceAliasDep);
+        this->addUsing(Result, MatchedNamespaceAliasDep);
     }
     else if (
         const auto *MatchedUsingDep
@@ -731,7 +784,7 @@ run(
             )
         )
     {
-        this->UsingDeps.push_back(MatchedUsingDep);
+        this->addUsing(Result, MatchedUsingDep);
     }
     else if (
         const auto *MatchedUsingNamespaceDep
@@ -740,42 +793,15 @@ run(
             )
         )
     {
-        this->UsingNamespaceDeps.push_back(MatchedUsingNamespaceDep);
+        this->addUsing(Result, MatchedUsingNamespaceDep);
     }
     else if (
         const auto *MatchedUsing
             = Result.Nodes.getNodeAs<clang::Decl>("using")
     )
     {
-        clang::NestedNameSpecifierLoc Nested;
-        switch (MatchedUsing->getKind())
-        {
-            case clang::Decl::Kind::NamespaceAlias:
-            {
-                const auto *Using
-                    = llvm::cast<clang::NamespaceAliasDecl>(MatchedUsing);
-                Nested = Using->getQualifierLoc();
-                break;
-            }
-            case clang::Decl::Kind::Using:
-            {
-                const auto *Using
-                    = llvm::cast<clang::UsingDecl>(MatchedUsing);
-                Nested = Using->getQualifierLoc();
-                break;
-            }
-            case clang::Decl::Kind::UsingDirective:
-            {
-                const auto *Using
-                    = llvm::cast<clang::UsingDirectiveDecl>(MatchedUsing);
-                Nested = Using->getQualifierLoc();
-                break;
-            }
-            default:
-            {
-                return;
-            }
-        }
+        clang::NestedNameSpecifierLoc Nested
+            = getUsingQualifierLoc(MatchedUsing);
 
         clang::SourceLocation Begin
             = getBeginLocationForUsing(Result, MatchedUsing);
@@ -793,7 +819,8 @@ run(
 #endif
 
         fixRemoveUsingNamespace(
-            this->FileToReplacements,
+            this->Store,
+            this->Policy,
             Result,
             MatchedUsing->getLocation(),
             Begin,
@@ -871,10 +898,10 @@ run(
             = Result.Nodes.getNodeAs<clang::Decl>("context");
 
         fixInlineNamespace(
-            this->FileToReplacements,
-            this->NamespaceAliasDeps,
-            this->UsingDeps,
-            this->UsingNamespaceDeps,
+            this->Store,
+            this->Scope,
+            this->Policy,
+            this->Usings,
             Result,
             MatchedExpr->getBeginLoc(),
             Begin,
@@ -921,10 +948,10 @@ run(
             = Result.Nodes.getNodeAs<clang::Decl>("context");
 
         fixInlineNamespace(
-            this->FileToReplacements,
-            this->NamespaceAliasDeps,
-            this->UsingDeps,
-            this->UsingNamespaceDeps,
+            this->Store,
+            this->Scope,
+            this->Policy,
+            this->Usings,
             Result,
             MatchedType->getBeginLoc(),
             Begin,
@@ -967,10 +994,10 @@ run(
             = Result.Nodes.getNodeAs<clang::Decl>("context");
 
         fixInlineNamespace(
-            this->FileToReplacements,
-            this->NamespaceAliasDeps,
-            this->UsingDeps,
-            this->UsingNamespaceDeps,
+            this->Store,
+            this->Scope,
+            this->Policy,
+            this->Usings,
             Result,
             MatchedNested->getBeginLoc(),
             Begin,
@@ -982,5 +1009,97 @@ run(
     }
 }
 
+void
+InlineNamespacesTool::
+onStartOfTranslationUnit()
+{
+    // File IDs and declarations are only unique within a translation unit.
+
+    this->ProjectFiles.clear();
+    this->FilteredNamespaces.clear();
+    this->HasProjectFiles.reset();
+    this->Usings.clear();
+}
+
+void
+InlineNamespacesTool::
+addUsing(
+    const MatchFinder::MatchResult &Result,
+    const clang::Decl *Using
+)
+{
+    // Only the ones left in place can shorten the references.
+
+    if (!isRemovedUsing(this->Scope, this->Policy, Result, Using))
+    {
+        this->Usings.add(*Result.Context, Using);
+    }
+}
+
+bool
+InlineNamespacesTool::
+isProjectFile(
+    const clang::SourceManager &SourceMgr,
+    clang::FileID ID
+)
+{
+    auto It = this->ProjectFiles.find(ID);
+    if (It != this->ProjectFiles.end())
+    {
+        return It->second;
+    }
+
+    bool Out = false;
+    if (const clang::FileEntry *Entry = SourceMgr.getFileEntryForID(ID))
+    {
+        Out = (
+            this->Pattern.match(Entry->getName())
+            || this->Pattern.match(Entry->tryGetRealPathName())
+        );
+    }
+
+    this->ProjectFiles[ID] = Out;
+    return Out;
+}
+
+bool
+InlineNamespacesTool::
+hasProjectFiles(
+    const clang::SourceManager &SourceMgr
+)
+{
+    if (!this->HasProjectFiles)
+    {
+        this->HasProjectFiles = false;
+        for (clang::FileID ID : this->Scope->getFiles())
+        {
+            if (this->isProjectFile(SourceMgr, ID))
+            {
+                this->HasProjectFiles = true;
+                break;
+            }
+        }
+    }
+
+    return *this->HasProjectFiles;
+}
+
+bool
+InlineNamespacesTool::
+isFilteredNamespace(
+    const clang::NamespaceDecl *Namespace
+)
+{
+    auto It = this->FilteredNamespaces.find(Namespace);
+    if (It != this->FilteredNamespaces.end())
+    {
+        return It->second;
+    }
+
+    bool Out = this->Policy.isKept(buildNamespace(Namespace));
+    this->FilteredNamespaces[Namespace] = Out;
+    return Out;
+}
+
 } // namespace inline_namespaces
 } // namespace pxr
@@ -1,16 +1,24 @@
 #ifndef INLINE_NAMESPACES_H
 #define INLINE_NAMESPACES_H
 
+#include "NamespacePolicy.h"
+#include "UsingIndex.h"
+#include "../FilePattern.h"
+
 #include <clang/AST/DeclCXX.h>
 #include <clang/ASTMatchers/ASTMatchFinder.h>
-#include <clang/Tooling/Core/Replacement.h>
-#include <llvm/ADT/SmallVector.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Optional.h>
 #include <llvm/ADT/StringRef.h>
 
-#include <map>
-#include <string>
-
 namespace pxr {
+
+class FileScope;
+class MatcherRegistry;
+class ReplacementStore;
+
 namespace inline_namespaces {
 
 class InlineNamespacesTool
@@ -18,13 +26,14 @@ class InlineNamespacesTool
 {
 public:
     InlineNamespacesTool(
-        std::map<std::string, clang::tooling::Replacements> *FileToReplacements,
-        llvm::StringRef FilePattern
+        ReplacementStore *Store,
+        FilePattern Pattern,
+        NamespacePolicy Policy
     );
 
     void
     registerMatchers(
-        clang::ast_matchers::MatchFinder *Finder
+        MatcherRegistry *Registry
     );
 
     void
@@ -32,12 +41,52 @@ public:
         const clang::ast_matchers::MatchFinder::MatchResult &Result
     ) override;
 
+    void
+    onStartOfTranslationUnit() override;
+
 private:
-    std::map<std::string, clang::tooling::Replacements> *FileToReplacements;
-    llvm::StringRef FilePattern;
-    llvm::SmallVector<const clang::NamespaceAliasDecl *> NamespaceAliasDeps;
-    llvm::SmallVector<const clang::UsingDecl *> UsingDeps;
-    llvm::SmallVector<const clang::UsingDirectiveDecl *> UsingNamespaceDeps;
+    // Whether the given file matches the file pattern. Only the files
+    // matching it are refactored.
+
+    bool
+    isProjectFile(
+        const clang::SourceManager &SourceMgr,
+        clang::FileID ID
+    );
+
+    // Whether any of the files in scope matches the file pattern. The files
+    // in scope are all known by the time that the matching starts.
+
+    bool
+    hasProjectFiles(
+        const clang::SourceManager &SourceMgr
+    );
+
+    // Record the given ‘using’ declaration, directive, or namespace alias if
+    // it is left in place.
+
+    void
+    addUsing(
+        const clang::ast_matchers::MatchFinder::MatchResult &Result,
+        const clang::Decl *Using
+    );
+
+    // Whether the references to the declarations within the given namespace
+    // are to be left untouched.
+
+    bool
+    isFilteredNamespace(
+        const clang::NamespaceDecl *Namespace
+    );
+
+    ReplacementStore *Store;
+    const FileScope *Scope = nullptr;
+    FilePattern Pattern;
+    NamespacePolicy Policy;
+    llvm::DenseMap<clang::FileID, bool> ProjectFiles;
+    llvm::Optional<bool> HasProjectFiles;
+    llvm::DenseMap<const clang::NamespaceDecl *, bool> FilteredNamespaces;
+    UsingIndex Usings;
 };
 
 } // namespace inline_namespaces
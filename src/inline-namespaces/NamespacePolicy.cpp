@@ -0,0 +1,354 @@
+#include "NamespacePolicy.h"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace pxr {
+namespace inline_namespaces {
+
+namespace {
+
+// Only the references to the declarations from these namespaces are inlined,
+// with a few exceptions.
+//
+// The hoisted namespaces are the ones brought into their parent by boost's
+// headers, which are never refactored.
+
+const char DefaultRules[] = R"(
+inline boost
+inline std
+
+keep boost::hash_value
+keep std::chrono_literals
+keep std::swap
+keep std swap
+
+hoist boost::operators_impl
+hoist boost::iterators
+hoist boost::python::api object
+hoist boost::python::self_ns self self_t
+)";
+
+} // anonymous namespace
+
+NamespacePolicy
+NamespacePolicy::
+getDefault()
+{
+    NamespacePolicy Out;
+    llvm::cantFail(Out.parse(DefaultRules, "<default>"));
+    return Out;
+}
+
+llvm::Error
+NamespacePolicy::
+parse(
+    llvm::StringRef Content,
+    llvm::StringRef Name
+)
+{
+    Data &Rules = this->getMutableData();
+    if (Rules.Nodes.empty())
+    {
+        Rules.Nodes.emplace_back();
+    }
+
+    llvm::SmallVector<llvm::StringRef> Lines;
+    Content.split(Lines, '\n');
+
+    for (size_t I = 0; I < Lines.size(); ++I)
+    {
+        llvm::StringRef Line = Lines[I].split('#').first.trim();
+        if (Line.empty())
+        {
+            continue;
+        }
+
+        llvm::SmallVector<llvm::StringRef> Words;
+        Line.split(Words, ' ', -1, false);
+
+        auto Fail = [&](const char *Message)
+        {
+            return llvm::createStringError(
+                llvm::inconvertibleErrorCode(),
+                "%s:%u: %s: ‘%s’.",
+                Name.str().c_str(),
+                unsigned(I + 1),
+                Message,
+                Line.str().c_str()
+            );
+        };
+
+        if (Words.size() < 2)
+        {
+            return Fail("Expected a rule followed by a namespace");
+        }
+
+        Action Inlining = Action::None;
+        bool Hoisted = false;
+        if (Words[0] == "inline")
+        {
+            Inlining = Action::Inline;
+        }
+        else if (Words[0] == "keep")
+        {
+            Inlining = Action::Keep;
+        }
+        else if (Words[0] == "hoist")
+        {
+            Hoisted = true;
+        }
+        else
+        {
+            return Fail("Unknown rule");
+        }
+
+        llvm::SmallVector<llvm::StringRef> Namespace;
+        Words[1].split(Namespace, "::");
+        if (llvm::is_contained(Namespace, llvm::StringRef()))
+        {
+            return Fail("Invalid namespace");
+        }
+
+        // Nodes are appended while walking, which invalidates the references
+        // to the previous ones.
+
+        unsigned Index = 0;
+        for (llvm::StringRef Segment : Namespace)
+        {
+            unsigned Key = this->intern(Segment);
+            auto It = Rules.Nodes[Index].Children.find(Key);
+            if (It != Rules.Nodes[Index].Children.end())
+            {
+                Index = It->second;
+                continue;
+            }
+
+            unsigned Child = unsigned(Rules.Nodes.size());
+            Rules.Nodes.emplace_back();
+            Rules.Nodes[Index].Children[Key] = Child;
+            Index = Child;
+        }
+
+        llvm::SmallVector<Rule *> Targets;
+        if (Words.size() == 2)
+        {
+            Targets.push_back(&Rules.Nodes[Index].All);
+        }
+
+        for (llvm::StringRef Symbol : llvm::makeArrayRef(Words).drop_front(2))
+        {
+            Targets.push_back(
+                &Rules.Nodes[Index].Symbols[this->intern(Symbol)]
+            );
+        }
+
+        for (Rule *Target : Targets)
+        {
+            if (Inlining != Action::None)
+            {
+                Target->Inlining = Inlining;
+            }
+
+            Target->Hoisted |= Hoisted;
+        }
+    }
+
+    Rules.Source += Content;
+    Rules.Source += '\n';
+    return llvm::Error::success();
+}
+
+llvm::Error
+NamespacePolicy::
+parseFile(
+    llvm::StringRef Path
+)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(Path);
+    if (!Buffer)
+    {
+        return llvm::createStringError(
+            Buffer.getError(),
+            "Failed reading the policy %s: %s.",
+            Path.str().c_str(),
+            Buffer.getError().message().c_str()
+        );
+    }
+
+    return this->parse((*Buffer)->getBuffer(), Path);
+}
+
+NamespacePolicy::Lookup
+NamespacePolicy::
+lookup(
+    llvm::ArrayRef<llvm::StringRef> Namespace,
+    llvm::StringRef SymbolName
+) const
+{
+    const Data &Rules = *this->Rules;
+
+    Lookup Out;
+    Out.Size = Namespace.size();
+    if (Namespace.empty() || Rules.Nodes.empty())
+    {
+        return Out;
+    }
+
+    unsigned Symbol = SymbolName.empty() ? 0 : this->findSegment(SymbolName);
+
+    // The rules of the innermost namespaces win, with the walk carrying on
+    // past the end of the trie to find the reserved namespaces.
+
+    Action Inlining = Action::None;
+    const Node *Current = &Rules.Nodes[0];
+    for (size_t I = 0; I < Namespace.size(); ++I)
+    {
+        bool Hoisted = Namespace[I].startswith("__");
+
+        if (Current)
+        {
+            auto It = Current->Children.find(this->findSegment(Namespace[I]));
+            Current
+                = It != Current->Children.end()
+                ? &Rules.Nodes[It->second]
+                : nullptr;
+        }
+
+        if (Current)
+        {
+            const Rule *SymbolRule = nullptr;
+            if (Symbol)
+            {
+                auto It = Current->Symbols.find(Symbol);
+                if (It != Current->Symbols.end())
+                {
+                    SymbolRule = &It->second;
+                }
+            }
+
+            if (SymbolRule && SymbolRule->Inlining != Action::None)
+            {
+                Inlining = SymbolRule->Inlining;
+            }
+            else if (Current->All.Inlining != Action::None)
+            {
+                Inlining = Current->All.Inlining;
+            }
+
+            Hoisted |= (
+                Current->All.Hoisted
+                || (SymbolRule && SymbolRule->Hoisted)
+            );
+        }
+
+        if (Hoisted)
+        {
+            Out.Size = I;
+        }
+    }
+
+    Out.Kept = Inlining != Action::Inline;
+    return Out;
+}
+
+bool
+NamespacePolicy::
+isKept(
+    llvm::ArrayRef<llvm::StringRef> Namespace
+) const
+{
+    const Data &Rules = *this->Rules;
+    if (Namespace.empty() || Rules.Nodes.empty())
+    {
+        return true;
+    }
+
+    Action Inlining = Action::None;
+    const Node *Current = &Rules.Nodes[0];
+    for (llvm::StringRef Segment : Namespace)
+    {
+        auto It = Current->Children.find(this->findSegment(Segment));
+        if (It == Current->Children.end())
+        {
+            break;
+        }
+
+        Current = &Rules.Nodes[It->second];
+        if (Current->All.Inlining != Action::None)
+        {
+            Inlining = Current->All.Inlining;
+        }
+
+        for (const auto &SymbolAndRule : Current->Symbols)
+        {
+            if (SymbolAndRule.second.Inlining == Action::Inline)
+            {
+                return false;
+            }
+        }
+    }
+
+    return Inlining != Action::Inline;
+}
+
+std::string
+NamespacePolicy::
+getKey() const
+{
+    llvm::SHA1 Hasher;
+    Hasher.update(this->Rules->Source);
+    return llvm::toHex(Hasher.final(), true);
+}
+
+unsigned
+NamespacePolicy::
+intern(
+    llvm::StringRef Segment
+)
+{
+    // The index 0 is left to the segments that aren't interned.
+
+    Data &Rules = this->getMutableData();
+    return Rules.Segments.try_emplace(
+        Segment, unsigned(Rules.Segments.size() + 1)
+    ).first->second;
+}
+
+unsigned
+NamespacePolicy::
+findSegment(
+    llvm::StringRef Segment
+) const
+{
+    auto It = this->Rules->Segments.find(Segment);
+    return It != this->Rules->Segments.end() ? It->second : 0;
+}
+
+NamespacePolicy::Data &
+NamespacePolicy::
+getMutableData()
+{
+    if (this->Rules.use_count() > 1)
+    {
+        this->Rules = std::make_shared<Data>(*this->Rules);
+    }
+
+    return *this->Rules;
+}
+
+} // namespace inline_namespaces
+} // namespace pxr
@@ -0,0 +1,157 @@
+#ifndef INLINE_NAMESPACES_NAMESPACE_POLICY_H
+#define INLINE_NAMESPACES_NAMESPACE_POLICY_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pxr {
+namespace inline_namespaces {
+
+// Rules deciding which namespaces get inlined into the references to their
+// declarations, and which ones are left out of these references.
+//
+// The rules are read one per line, with ‘#’ starting a comment:
+//
+//   inline <namespace> [<symbol>...]
+//   keep <namespace> [<symbol>...]
+//   hoist <namespace> [<symbol>...]
+//
+// An ‘inline’ rule makes the references to the declarations within the given
+// namespace, or within any namespace nested in it, fully qualified, while
+// a ‘keep’ rule leaves them untouched. The rule for the innermost namespace
+// wins, and a rule restricted to some symbols wins over the one that isn't.
+// The namespaces without any rule are kept.
+//
+// A ‘hoist’ rule tells that the declarations within the given namespace are
+// brought into its parent namespace, such as with a ‘using’ directive from
+// a header that isn't refactored, so that the references go through the parent
+// namespace instead. The namespaces reserved to the implementation, starting
+// with ‘__’, are always hoisted.
+//
+// The rules are compiled into a trie keyed on the interned components of
+// the namespaces, to be looked up with a single walk per reference.
+
+class NamespacePolicy
+{
+public:
+    // Outcome of looking up a namespace, and a symbol declared in it.
+
+    struct Lookup
+    {
+        // Whether the references are to be left untouched.
+        bool Kept = true;
+
+        // Number of leading components of the namespace to spell in the
+        // references, once the hoisted ones are left out.
+        size_t Size = 0;
+    };
+
+    // Rules that the tool applies by default.
+
+    static NamespacePolicy
+    getDefault();
+
+    // Parse the given rules, on top of the ones already parsed. Rules for
+    // the same namespace and symbols override the previous ones.
+
+    llvm::Error
+    parse(
+        llvm::StringRef Content,
+        llvm::StringRef Name
+    );
+
+    // Read the rules from a file, on top of the ones already parsed.
+
+    llvm::Error
+    parseFile(
+        llvm::StringRef Path
+    );
+
+    // Look up the given namespace, made of its non-inline components, and
+    // the given symbol declared in it, if any.
+
+    Lookup
+    lookup(
+        llvm::ArrayRef<llvm::StringRef> Namespace,
+        llvm::StringRef SymbolName = llvm::StringRef()
+    ) const;
+
+    // Whether the references to all the declarations within the given
+    // namespace are left untouched, including the ones to the symbols that
+    // have rules of their own.
+
+    bool
+    isKept(
+        llvm::ArrayRef<llvm::StringRef> Namespace
+    ) const;
+
+    // Hash identifying the rules, to key what depends on them with.
+
+    std::string
+    getKey() const;
+
+private:
+    enum class Action
+    {
+        None,
+        Inline,
+        Keep,
+    };
+
+    // Rule attached to a namespace, either for all its symbols or for some
+    // of them only.
+
+    struct Rule
+    {
+        Action Inlining = Action::None;
+        bool Hoisted = false;
+    };
+
+    struct Node
+    {
+        Rule All;
+        llvm::SmallDenseMap<unsigned, Rule, 2> Symbols;
+        llvm::SmallDenseMap<unsigned, unsigned, 4> Children;
+    };
+
+    // The rules are shared across the copies held by each worker, and are
+    // copied before being modified if shared.
+
+    struct Data
+    {
+        llvm::StringMap<unsigned> Segments;
+        std::vector<Node> Nodes;
+        std::string Source;
+    };
+
+    unsigned
+    intern(
+        llvm::StringRef Segment
+    );
+
+    // Index of the given segment, or 0 if it isn't part of any rule.
+
+    unsigned
+    findSegment(
+        llvm::StringRef Segment
+    ) const;
+
+    Data &
+    getMutableData();
+
+    std::shared_ptr<Data> Rules = std::make_shared<Data>();
+};
+
+} // namespace inline_namespaces
+} // namespace pxr
+
+#endif // INLINE_NAMESPACES_NAMESPACE_POLICY_H
@@ -0,0 +1,305 @@
+#include "UsingIndex.h"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/ASTTypeTraits.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclBase.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Stmt.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Casting.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace pxr {
+namespace inline_namespaces {
+
+namespace {
+
+// Innermost namespace that the given declaration is lexically within, which
+// is how the namespace of the declarations referenced is found.
+
+const clang::NamespaceDecl *
+getLexicalNamespace(
+    const clang::Decl *Decl
+)
+{
+    for (
+        const clang::DeclContext *Ctx = Decl->getLexicalDeclContext();
+        Ctx;
+        Ctx = Ctx->getLexicalParent()
+    )
+    {
+        if (const auto *Namespace = llvm::dyn_cast<clang::NamespaceDecl>(Ctx))
+        {
+            return Namespace->getCanonicalDecl();
+        }
+    }
+
+    return nullptr;
+}
+
+// End of the block that the given declaration is in, or an invalid location
+// if it is declared at the scope of a namespace or of a class.
+
+clang::SourceLocation
+getBlockEnd(
+    clang::ASTContext &Context,
+    const clang::Decl *Decl
+)
+{
+    clang::DynTypedNodeList Parents = Context.getParents(*Decl);
+    while (!Parents.empty() && !Parents[0].get<clang::Decl>())
+    {
+        if (const auto *Block = Parents[0].get<clang::CompoundStmt>())
+        {
+            return Block->getRBracLoc();
+        }
+
+        Parents = Context.getParents(Parents[0]);
+    }
+
+    return clang::SourceLocation();
+}
+
+} // anonymous namespace
+
+void
+UsingIndex::
+clear()
+{
+    this->Entries.clear();
+}
+
+void
+UsingIndex::
+add(
+    clang::ASTContext &Context,
+    const clang::Decl *Decl
+)
+{
+    const clang::SourceManager &SourceMgr = Context.getSourceManager();
+    const clang::DeclContext *Ctx = Decl->getDeclContext();
+
+    Entry E;
+    E.Begin = SourceMgr.getExpansionLoc(Decl->getEndLoc());
+
+    clang::SourceLocation End = getBlockEnd(Context, Decl);
+    if (End.isValid())
+    {
+        E.End = SourceMgr.getExpansionLoc(End);
+    }
+
+    if (
+        const auto *Directive = llvm::dyn_cast<clang::UsingDirectiveDecl>(Decl)
+    )
+    {
+        if (
+            const clang::NamespaceDecl *Namespace
+                = Directive->getNominatedNamespace()
+        )
+        {
+            this->insert(
+                SourceMgr,
+                Key(Kind::Directive, Ctx, Namespace->getCanonicalDecl(), ""),
+                E
+            );
+        }
+    }
+    else if (
+        const auto *Alias = llvm::dyn_cast<clang::NamespaceAliasDecl>(Decl)
+    )
+    {
+        if (const clang::NamespaceDecl *Namespace = Alias->getNamespace())
+        {
+            E.Alias = Alias->getName();
+            this->insert(
+                SourceMgr,
+                Key(Kind::Alias, Ctx, Namespace->getCanonicalDecl(), ""),
+                E
+            );
+        }
+    }
+    else if (const auto *Using = llvm::dyn_cast<clang::UsingDecl>(Decl))
+    {
+        // Each overload brought in has its own shadow declaration, but they
+        // all share the same namespace.
+
+        std::string Name = Using->getNameAsString();
+        llvm::SmallVector<const clang::NamespaceDecl *, 1> Namespaces;
+        for (const clang::UsingShadowDecl *Shadow : Using->shadows())
+        {
+            const clang::NamespaceDecl *Namespace
+                = getLexicalNamespace(Shadow->getTargetDecl());
+            if (
+                Namespace
+                && std::find(Namespaces.begin(), Namespaces.end(), Namespace)
+                    == Namespaces.end()
+            )
+            {
+                Namespaces.push_back(Namespace);
+                this->insert(
+                    SourceMgr, Key(Kind::Declaration, Ctx, Namespace, Name), E
+                );
+            }
+        }
+    }
+}
+
+Shortening
+UsingIndex::
+find(
+    const clang::SourceManager &SourceMgr,
+    const clang::DeclContext *Context,
+    clang::SourceLocation Loc,
+    const clang::NamespaceDecl *Namespace,
+    llvm::StringRef SymbolName
+) const
+{
+    Shortening Out;
+    if (this->Entries.empty() || !Namespace)
+    {
+        return Out;
+    }
+
+    // Namespaces from the outermost one, each along with the number of
+    // components that it spans, which leaves out the inline namespaces.
+
+    llvm::SmallVector<std::pair<const clang::NamespaceDecl *, size_t>> Chain;
+    for (const clang::DeclContext *Ctx = Namespace; Ctx; Ctx = Ctx->getParent())
+    {
+        if (const auto *Decl = llvm::dyn_cast<clang::NamespaceDecl>(Ctx))
+        {
+            Chain.emplace_back(Decl->getCanonicalDecl(), 0);
+        }
+    }
+
+    std::reverse(Chain.begin(), Chain.end());
+
+    size_t Size = 0;
+    for (auto &It : Chain)
+    {
+        if (!It.first->isInline())
+        {
+            ++Size;
+        }
+
+        It.second = Size;
+    }
+
+    size_t Length = Size;
+    auto Consider = [&](size_t Count, llvm::StringRef Alias)
+    {
+        size_t CandidateLength = Size - Count + (Alias.empty() ? 0 : 1);
+        if (CandidateLength < Length)
+        {
+            Length = CandidateLength;
+            Out.Count = Count;
+            Out.Alias = Alias;
+        }
+    };
+
+    std::string Name(SymbolName);
+    for (const clang::DeclContext *Ctx = Context; Ctx; Ctx = Ctx->getParent())
+    {
+        // Nothing is shorter than the symbol being brought in.
+
+        Key K(Kind::Declaration, Ctx, Namespace->getCanonicalDecl(), Name);
+        if (this->findVisible(SourceMgr, K, Loc))
+        {
+            Out.Count = Size;
+            Out.Alias = llvm::StringRef();
+            return Out;
+        }
+
+        for (const auto &It : Chain)
+        {
+            if (
+                this->findVisible(
+                    SourceMgr, Key(Kind::Directive, Ctx, It.first, ""), Loc
+                )
+            )
+            {
+                Consider(It.second, llvm::StringRef());
+            }
+
+            if (
+                const Entry *E = this->findVisible(
+                    SourceMgr, Key(Kind::Alias, Ctx, It.first, ""), Loc
+                )
+            )
+            {
+                Consider(It.second, E->Alias);
+            }
+        }
+    }
+
+    return Out;
+}
+
+void
+UsingIndex::
+insert(
+    const clang::SourceManager &SourceMgr,
+    Key K,
+    Entry E
+)
+{
+    // The declarations are mostly added in the order of the translation
+    // unit, so these are appended most of the time.
+
+    llvm::SmallVector<Entry, 1> &Sorted = this->Entries[std::move(K)];
+    auto It = std::upper_bound(
+        Sorted.begin(),
+        Sorted.end(),
+        E,
+        [&SourceMgr](const Entry &A, const Entry &B)
+        {
+            return SourceMgr.isBeforeInTranslationUnit(A.Begin, B.Begin);
+        }
+    );
+
+    Sorted.insert(It, E);
+}
+
+const UsingIndex::Entry *
+UsingIndex::
+findVisible(
+    const clang::SourceManager &SourceMgr,
+    const Key &K,
+    clang::SourceLocation Loc
+) const
+{
+    auto It = this->Entries.find(K);
+    if (It == this->Entries.end())
+    {
+        return nullptr;
+    }
+
+    for (const Entry &E : It->second)
+    {
+        if (!SourceMgr.isBeforeInTranslationUnit(E.Begin, Loc))
+        {
+            break;
+        }
+
+        if (
+            E.End.isInvalid()
+            || SourceMgr.isBeforeInTranslationUnit(Loc, E.End)
+        )
+        {
+            return &E;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace inline_namespaces
+} // namespace pxr
@@ -0,0 +1,115 @@
+#ifndef INLINE_NAMESPACES_USING_INDEX_H
+#define INLINE_NAMESPACES_USING_INDEX_H
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclBase.h>
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <tuple>
+
+namespace pxr {
+namespace inline_namespaces {
+
+// Part of a namespace that a reference can omit, either because it is made
+// visible by a ‘using’ directive or declaration, or because a namespace alias
+// refers to it.
+
+struct Shortening
+{
+    // Number of leading components of the namespace to omit.
+    size_t Count = 0;
+
+    // Alias to spell in place of these components, if any.
+    llvm::StringRef Alias;
+};
+
+// ‘using’ declarations and directives, and namespace aliases, that are left
+// in place within a translation unit, indexed by the context that they are
+// declared in and by what they refer to.
+//
+// Finding the ones visible from a reference is a lookup per enclosing
+// context, rather than a scan over all of them. Each one is only visible from
+// the end of its declaration, and until the end of its block, if any.
+//
+// The declarations are only valid for the translation unit being processed.
+
+class UsingIndex
+{
+public:
+    void
+    clear();
+
+    void
+    add(
+        clang::ASTContext &Context,
+        const clang::Decl *Decl
+    );
+
+    // Shortest way to refer to the symbol of the given name, declared in
+    // the given namespace, from the given context and location. The namespace
+    // components are the ones of its non-inline namespaces.
+
+    Shortening
+    find(
+        const clang::SourceManager &SourceMgr,
+        const clang::DeclContext *Context,
+        clang::SourceLocation Loc,
+        const clang::NamespaceDecl *Namespace,
+        llvm::StringRef SymbolName
+    ) const;
+
+private:
+    enum class Kind
+    {
+        Declaration,
+        Directive,
+        Alias,
+    };
+
+    struct Entry
+    {
+        clang::SourceLocation Begin;
+        clang::SourceLocation End;
+        llvm::StringRef Alias;
+    };
+
+    // Context declaring the entries, namespace that they refer to, and name
+    // of the symbol for the ‘using’ declarations.
+    using Key = std::tuple<
+        Kind,
+        const clang::DeclContext *,
+        const clang::NamespaceDecl *,
+        std::string
+    >;
+
+    void
+    insert(
+        const clang::SourceManager &SourceMgr,
+        Key K,
+        Entry E
+    );
+
+    // First entry for the given key visible from the given location.
+
+    const Entry *
+    findVisible(
+        const clang::SourceManager &SourceMgr,
+        const Key &K,
+        clang::SourceLocation Loc
+    ) const;
+
+    // Entries sorted by their beginning in the translation unit.
+    std::map<Key, llvm::SmallVector<Entry, 1>> Entries;
+};
+
+} // namespace inline_namespaces
+} // namespace pxr
+
+#endif // INLINE_NAMESPACES_USING_INDEX_H
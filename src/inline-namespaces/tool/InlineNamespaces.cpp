@@ -1,25 +1,32 @@
 #include "../InlineNamespaces.h"
+#include "../NamespacePolicy.h"
+#include "../../Apply.h"
+#include "../../Executor.h"
+#include "../../Export.h"
+#include "../../FilePattern.h"
+#include "../../MatcherRegistry.h"
+#include "../../Options.h"
+#include "../../ReplacementStore.h"
+#include "../../Report.h"
+#include "../../Server.h"
+#include "../../StreamingWriter.h"
 
 #include <clang/ASTMatchers/ASTMatchers.h>
-#include <clang/Basic/DiagnosticOptions.h>
-#include <clang/Basic/Diagnostic.h>
-#include <clang/Basic/DiagnosticIDs.h>
-#include <clang/Basic/FileManager.h>
-#include <clang/Basic/LangOptions.h>
-#include <clang/Basic/SourceManager.h>
-#include <clang/Frontend/TextDiagnosticPrinter.h>
-#include <clang/Rewrite/Core/Rewriter.h>
 #include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/Core/Replacement.h>
 #include <clang/Tooling/Tooling.h>
-#include <clang/Tooling/Refactoring.h>
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
 #include <llvm/Support/Signals.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace {
 
@@ -46,7 +53,20 @@ llvm::cl::opt<bool> Dump(
 llvm::cl::opt<std::string> FilePattern(
     "file-pattern",
     llvm::cl::Required,
-    llvm::cl::desc("Only consider namespaces in the files matching the given pattern."),
+    llvm::cl::desc(
+        "Only refactor the files matching the given pattern, either a glob "
+        "pattern or, if starting with ‘^’, a regular expression."
+    ),
+    llvm::cl::cat(InlineNamespacesCategory)
+);
+
+llvm::cl::list<std::string> PolicyFiles(
+    "policy",
+    llvm::cl::desc(
+        "Read more rules deciding which namespaces to inline from the given "
+        "file, on top of the default ones."
+    ),
+    llvm::cl::ZeroOrMore,
     llvm::cl::cat(InlineNamespacesCategory)
 );
 
@@ -59,9 +79,12 @@ main(
 )
 {
     llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+    pxr::addCommonOptions(InlineNamespacesCategory);
+
+    // No files are needed on the command line when serving these.
 
     auto ExpectedParser = clang::tooling::CommonOptionsParser::create(
-        argc, argv, InlineNamespacesCategory
+        argc, argv, InlineNamespacesCategory, llvm::cl::ZeroOrMore
     );
     if (!ExpectedParser)
     {
@@ -71,79 +94,150 @@ main(
 
     clang::tooling::CommonOptionsParser &OptionsParser = ExpectedParser.get();
 
-    clang::tooling::RefactoringTool Tool(
-        OptionsParser.getCompilations(), OptionsParser.getSourcePathList()
-    );
+    pxr::CommonOptions CommonOptions;
+    if (!pxr::getCommonOptions(&CommonOptions))
+    {
+        return 1;
+    }
 
-    pxr::inline_namespaces::InlineNamespacesTool PxrTool(
-        &Tool.getReplacements(), FilePattern
+    pxr::inline_namespaces::NamespacePolicy Policy
+        = pxr::inline_namespaces::NamespacePolicy::getDefault();
+    for (const std::string &Path : PolicyFiles)
+    {
+        if (llvm::Error Error = Policy.parseFile(Path))
+        {
+            llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+            return 1;
+        }
+    }
+
+    // The cached replacements also depend on the options of the tool.
+
+    CommonOptions.Executor.CacheKey += "\n--root=" + Root;
+    CommonOptions.Executor.CacheKey += "\n--file-pattern=" + FilePattern;
+    CommonOptions.Executor.CacheKey += "\n--policy=" + Policy.getKey();
+
+    llvm::Expected<pxr::FilePattern> Pattern
+        = pxr::FilePattern::create(FilePattern);
+    if (!Pattern)
+    {
+        llvm::errs() << llvm::toString(Pattern.takeError()) << "\n";
+        return 1;
+    }
+
+    pxr::Executor Executor(
+        OptionsParser.getCompilations(),
+        [&Pattern, &Policy](
+            pxr::ReplacementStore *Store,
+            pxr::MatcherRegistry *Registry
+        )
+        {
+            auto PxrTool
+                = std::make_unique<pxr::inline_namespaces::InlineNamespacesTool>(
+                    Store, *Pattern, Policy
+                );
+            PxrTool->registerMatchers(Registry);
+            return PxrTool;
+        },
+        CommonOptions.Executor
     );
 
-    clang::ast_matchers::MatchFinder Finder;
-    PxrTool.registerMatchers(&Finder);
-    std::unique_ptr<clang::tooling::FrontendActionFactory> Factory =
-        clang::tooling::newFrontendActionFactory(&Finder);
+    // No lexical filter is set, since the tokens of a source can't tell
+    // whether its unqualified names come from a ‘using’ in a header, or are
+    // found through ADL.
 
-    if (int Result = Tool.run(Factory.get()))
+    if (!CommonOptions.ServePath.empty())
     {
-        return Result;
+        return pxr::serve(CommonOptions.ServePath, &Executor);
     }
 
-    clang::LangOptions DefaultLangOptions;
-    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> DiagOpts
-        = new clang::DiagnosticOptions();
-    clang::TextDiagnosticPrinter DiagnosticPrinter(llvm::errs(), &*DiagOpts);
-    clang::DiagnosticsEngine Diagnostics(
-        llvm::IntrusiveRefCntPtr<clang::DiagnosticIDs>(
-            new clang::DiagnosticIDs()
-        ),
-        &*DiagOpts,
-        &DiagnosticPrinter,
-        false
+    pxr::ReplacementStore Store;
+    Store.setDiagnosticsEnabled(
+        CommonOptions.Report == pxr::ReportFormat::Diagnostics
     );
 
-    clang::FileManager &FileMgr(Tool.getFiles());
-    clang::SourceManager SourceMgr(Diagnostics, FileMgr);
-    clang::Rewriter Rewrite(SourceMgr, DefaultLangOptions);
+    // Write each file as soon as the source having it in scope is processed
+    // rather than once all the sources are.
 
-    std::map<std::string, clang::tooling::Replacements> GroupedReplacements
-        = clang::tooling::groupReplacementsByFile(
-            Rewrite.getSourceMgr().getFileManager(), Tool.getReplacements()
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> RealFileSystem
+        = llvm::vfs::getRealFileSystem();
+    pxr::StreamingWriter Writer(
+        *RealFileSystem, Overwrite, Dump ? &llvm::outs() : nullptr
+    );
+    if (CommonOptions.Stream)
+    {
+        Executor.setResultSink(
+            [&Writer](const pxr::ReplacementStore &Result)
+            {
+                return Writer.write(Result);
+            }
         );
-    for (const auto &FileAndReplaces: GroupedReplacements)
+    }
+
+    if (int Result = Executor.run(OptionsParser.getSourcePathList(), &Store))
+    {
+        return Result;
+    }
+
+    Store.reportConflicts(llvm::errs());
+    if (
+        !pxr::writeReport(
+            CommonOptions.ReportPath,
+            CommonOptions.Report,
+            Store,
+            CommonOptions.Executor.ProfileMatchers
+                ? &Executor.getMatcherTimes()
+                : nullptr,
+            CommonOptions.Executor.ProfileMatchers
+                ? &Executor.getMatchCounts()
+                : nullptr
+        )
+    )
+    {
+        return 1;
+    }
+
+    if (CommonOptions.Stream)
     {
-        const clang::tooling::Replacements &Replaces = FileAndReplaces.second;
-        if (!clang::tooling::applyAllReplacements(Replaces, Rewrite))
+        return 0;
+    }
+
+    std::map<std::string, clang::tooling::Replacements> FileToReplacements
+        = Store.getFileToReplacements();
+
+    // Leave it to an external step to merge and apply the replacements.
+
+    if (!CommonOptions.ExportPath.empty())
+    {
+        if (
+            !pxr::exportReplacements(
+                CommonOptions.ExportPath, "", FileToReplacements
+            )
+        )
         {
-            const std::string &FilePath = FileAndReplaces.first;
-            llvm::errs()
-                << "Failed applying replacements for file "
-                << FilePath.c_str()
-                << ".\n";
             return 1;
         }
+
+        return 0;
+    }
+
+    std::map<std::string, std::string> FileToContent;
+    if (
+        !pxr::applyReplacements(
+            FileToReplacements, *llvm::vfs::getRealFileSystem(), &FileToContent
+        )
+    )
+    {
+        return 1;
     }
 
     if (Dump)
     {
-        for (const auto &it : Tool.getReplacements())
-        {
-            llvm::StringRef File = it.first;
-            const llvm::ErrorOr<const clang::FileEntry *> Entry
-                = FileMgr.getFile(File);
-
-            clang::FileID ID
-                = SourceMgr.getOrCreateFileID(*Entry, clang::SrcMgr::C_User);
-            llvm::outs() << "============== " << File << " ==============\n";
-            Rewrite.getEditBuffer(ID).write(llvm::outs());
-            llvm::outs() << "\n============================================\n";
-        }
+        pxr::dumpFiles(FileToContent, llvm::outs());
     }
 
-    if (Overwrite && Rewrite.overwriteChangedFiles())
+    if (Overwrite && !pxr::writeFiles(FileToContent))
     {
-        llvm::errs()
-            << "Failed writing the changes to the files.\n";
         return 1;
     }
 
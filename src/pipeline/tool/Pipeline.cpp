@@ -0,0 +1,531 @@
+// Run the ‘inline-namespaces’ and ‘disambiguate-symbols’ tools one after
+// the other within a single process.
+//
+// The changes from the first pass are kept in memory, overlaid onto the disk,
+// for the second pass to parse, and the files are only written once both
+// passes are done.
+
+#include "../../Apply.h"
+#include "../../Executor.h"
+#include "../../Export.h"
+#include "../../FilePattern.h"
+#include "../../LexicalFilter.h"
+#include "../../MatcherRegistry.h"
+#include "../../Options.h"
+#include "../../ReplacementStore.h"
+#include "../../Report.h"
+#include "../../disambiguate-symbols/DisambiguateSymbols.h"
+#include "../../inline-namespaces/InlineNamespaces.h"
+#include "../../inline-namespaces/NamespacePolicy.h"
+
+#include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/Core/Replacement.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Signals.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+llvm::cl::OptionCategory PipelineCategory("Pipeline");
+
+llvm::cl::opt<std::string> Root(
+    "root",
+    llvm::cl::desc("Path to USD's root directory."),
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::opt<bool> Overwrite(
+    "overwrite",
+    llvm::cl::desc("Overwrite the files."),
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::opt<bool> Dump(
+    "dump",
+    llvm::cl::desc("Dump the result of the changes to stdout."),
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::opt<std::string> FilePattern(
+    "file-pattern",
+    llvm::cl::Required,
+    llvm::cl::desc(
+        "Only refactor the files matching the given pattern in the "
+        "‘inline-namespaces’ pass, either a glob pattern or, if starting "
+        "with ‘^’, a regular expression."
+    ),
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::opt<std::string> InlineNamespacesExclude(
+    "inline-namespaces-exclude",
+    llvm::cl::desc(
+        "Skip the files matching the given pattern in the "
+        "‘inline-namespaces’ pass."
+    ),
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::list<std::string> PolicyFiles(
+    "policy",
+    llvm::cl::desc(
+        "Read more rules deciding which namespaces to inline from the given "
+        "file, on top of the default ones, in the ‘inline-namespaces’ pass."
+    ),
+    llvm::cl::ZeroOrMore,
+    llvm::cl::cat(PipelineCategory)
+);
+
+llvm::cl::opt<std::string> DisambiguateSymbolsExclude(
+    "disambiguate-symbols-exclude",
+    llvm::cl::desc(
+        "Skip the files matching the given pattern in the "
+        "‘disambiguate-symbols’ pass."
+    ),
+    llvm::cl::cat(PipelineCategory)
+);
+
+bool
+filterSources(
+    llvm::ArrayRef<std::string> SourcePaths,
+    llvm::StringRef Exclude,
+    std::vector<std::string> *Out
+)
+{
+    if (Exclude.empty())
+    {
+        Out->assign(SourcePaths.begin(), SourcePaths.end());
+        return true;
+    }
+
+    llvm::Expected<pxr::FilePattern> Pattern
+        = pxr::FilePattern::create(Exclude);
+    if (!Pattern)
+    {
+        llvm::errs() << llvm::toString(Pattern.takeError()) << "\n";
+        return false;
+    }
+
+    for (const std::string &SourcePath : SourcePaths)
+    {
+        if (!Pattern->match(SourcePath))
+        {
+            Out->push_back(SourcePath);
+        }
+    }
+
+    return true;
+}
+
+// File system overlaying the given contents onto the disk. The contents are
+// referred to rather than copied, so they must outlive the file system.
+//
+// Each worker of the executor gets its own overlay, since changing
+// the working directory of one changes the one of its layers.
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+createOverlay(
+    const std::map<std::string, std::string> &FileToContent
+)
+{
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> RealFileSystem(
+        llvm::vfs::createPhysicalFileSystem().release()
+    );
+    llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> MemoryFileSystem(
+        new llvm::vfs::InMemoryFileSystem()
+    );
+
+    for (const auto &FileAndContent : FileToContent)
+    {
+        llvm::ErrorOr<llvm::vfs::Status> Status
+            = RealFileSystem->status(FileAndContent.first);
+        MemoryFileSystem->addFile(
+            FileAndContent.first,
+            Status ? llvm::sys::toTimeT(Status->getLastModificationTime()) : 0,
+            llvm::MemoryBuffer::getMemBuffer(
+                FileAndContent.second, FileAndContent.first
+            )
+        );
+    }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> Out(
+        new llvm::vfs::OverlayFileSystem(RealFileSystem)
+    );
+    Out->pushOverlay(MemoryFileSystem);
+    return Out;
+}
+
+// Report file of a pass, named after the one given with the name of the pass
+// inserted before its extension.
+
+std::string
+getPassReportPath(
+    llvm::StringRef ReportPath,
+    llvm::StringRef Pass
+)
+{
+    if (ReportPath.empty() || ReportPath == "-")
+    {
+        return ReportPath.str();
+    }
+
+    llvm::SmallString<256> Out(ReportPath);
+    llvm::StringRef Extension = llvm::sys::path::extension(ReportPath);
+    llvm::sys::path::replace_extension(Out, "");
+    Out += ".";
+    Out += Pass;
+    Out += Extension;
+    return std::string(Out.str());
+}
+
+int
+runPass(
+    llvm::StringRef Name,
+    const clang::tooling::CompilationDatabase &Compilations,
+    pxr::CallbackFactory Factory,
+    pxr::LexicalFilter Filter,
+    const pxr::CommonOptions &CommonOptions,
+    pxr::FileSystemFactory FileSystems,
+    llvm::ArrayRef<std::string> SourcePaths,
+    pxr::ReplacementStore *Store
+)
+{
+    pxr::ExecutorOptions Options = CommonOptions.Executor;
+    Options.CacheKey += "\n--pass=" + Name.str();
+    if (!Options.TimingsPath.empty())
+    {
+        Options.TimingsPath += "." + Name.str();
+    }
+
+    pxr::Executor Executor(Compilations, std::move(Factory), Options);
+    Executor.setLexicalFilter(std::move(Filter));
+    Executor.setFileSystemFactory(std::move(FileSystems));
+
+    Store->setDiagnosticsEnabled(
+        CommonOptions.Report == pxr::ReportFormat::Diagnostics
+    );
+
+    if (int Result = Executor.run(SourcePaths, Store))
+    {
+        return Result;
+    }
+
+    Store->reportConflicts(llvm::errs());
+    if (
+        !pxr::writeReport(
+            getPassReportPath(CommonOptions.ReportPath, Name),
+            CommonOptions.Report,
+            *Store,
+            Options.ProfileMatchers ? &Executor.getMatcherTimes() : nullptr,
+            Options.ProfileMatchers ? &Executor.getMatchCounts() : nullptr
+        )
+    )
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(
+    int argc,
+    const char **argv
+)
+{
+    llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+    pxr::addCommonOptions(PipelineCategory);
+
+    auto ExpectedParser = clang::tooling::CommonOptionsParser::create(
+        argc, argv, PipelineCategory
+    );
+    if (!ExpectedParser)
+    {
+        llvm::errs() << ExpectedParser.takeError();
+        return 1;
+    }
+
+    clang::tooling::CommonOptionsParser &OptionsParser = ExpectedParser.get();
+
+    pxr::CommonOptions CommonOptions;
+    if (!pxr::getCommonOptions(&CommonOptions))
+    {
+        return 1;
+    }
+
+    if (!CommonOptions.ServePath.empty())
+    {
+        llvm::errs() << "The pipeline can't serve requests.\n";
+        return 1;
+    }
+
+    // The second pass reads the files as left by the first one, which only
+    // holds their content in memory until the end.
+
+    if (CommonOptions.Stream)
+    {
+        llvm::errs() << "The pipeline can't stream its replacements.\n";
+        return 1;
+    }
+
+    // The lines changed by the diff move once the first pass is applied.
+
+    if (CommonOptions.Executor.Changes)
+    {
+        llvm::errs() << "The pipeline can't be restricted to a diff.\n";
+        return 1;
+    }
+
+    // The ASTs are loaded from the disk rather than through the content left
+    // by the first pass, and are only checked against the content of their
+    // main file, so the second pass would reuse the stale ones of the first.
+
+    if (!CommonOptions.Executor.ASTCacheDirectory.empty())
+    {
+        llvm::errs() << "The pipeline can't cache the ASTs.\n";
+        return 1;
+    }
+
+    // Its second pass fixes the symbols of anonymous namespaces clashing once
+    // the sources are compiled together, so these sources can't be parsed
+    // from within a unity unit in the first place.
+
+    if (CommonOptions.Executor.UnityUnits)
+    {
+        llvm::errs() << "The pipeline can't refactor unity units.\n";
+        return 1;
+    }
+
+    pxr::inline_namespaces::NamespacePolicy Policy
+        = pxr::inline_namespaces::NamespacePolicy::getDefault();
+    for (const std::string &Path : PolicyFiles)
+    {
+        if (llvm::Error Error = Policy.parseFile(Path))
+        {
+            llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+            return 1;
+        }
+    }
+
+    // The cached replacements also depend on the options of the tools.
+
+    CommonOptions.Executor.CacheKey += "\n--root=" + Root;
+    CommonOptions.Executor.CacheKey += "\n--file-pattern=" + FilePattern;
+    CommonOptions.Executor.CacheKey += "\n--policy=" + Policy.getKey();
+
+    llvm::Expected<pxr::FilePattern> Pattern
+        = pxr::FilePattern::create(FilePattern);
+    if (!Pattern)
+    {
+        llvm::errs() << llvm::toString(Pattern.takeError()) << "\n";
+        return 1;
+    }
+
+    std::vector<std::string> InlineNamespacesSources;
+    std::vector<std::string> DisambiguateSymbolsSources;
+    if (
+        !filterSources(
+            OptionsParser.getSourcePathList(),
+            InlineNamespacesExclude,
+            &InlineNamespacesSources
+        )
+        || !filterSources(
+            OptionsParser.getSourcePathList(),
+            DisambiguateSymbolsExclude,
+            &DisambiguateSymbolsSources
+        )
+    )
+    {
+        return 1;
+    }
+
+    // Both passes read the files through overlays of the changes made by
+    // the first pass, which are empty during the first pass.
+
+    std::map<std::string, std::string> FileToContent;
+    pxr::FileSystemFactory FileSystems = [&FileToContent]()
+    {
+        return createOverlay(FileToContent);
+    };
+
+    // First pass, with its changes then overlaid onto the disk.
+
+    pxr::ReplacementStore InlineNamespacesStore;
+    if (
+        int Result = runPass(
+            "inline-namespaces",
+            OptionsParser.getCompilations(),
+            [&Pattern, &Policy](
+                pxr::ReplacementStore *Store,
+                pxr::MatcherRegistry *Registry
+            )
+            {
+                auto PxrTool
+                    = std::make_unique<
+                        pxr::inline_namespaces::InlineNamespacesTool
+                    >(Store, *Pattern, Policy);
+                PxrTool->registerMatchers(Registry);
+                return PxrTool;
+            },
+            // Unqualified references found through a ‘using’ from a header,
+            // or through ADL, don't show in the tokens of a source.
+            nullptr,
+            CommonOptions,
+            FileSystems,
+            InlineNamespacesSources,
+            &InlineNamespacesStore
+        )
+    )
+    {
+        return Result;
+    }
+
+    // The overlays refer to the contents, which are thus only replaced once
+    // all of them are known.
+
+    std::map<std::string, std::string> InlineNamespacesContents;
+    if (
+        !pxr::applyReplacements(
+            InlineNamespacesStore.getFileToReplacements(),
+            *FileSystems(),
+            &InlineNamespacesContents
+        )
+    )
+    {
+        return 1;
+    }
+
+    FileToContent = std::move(InlineNamespacesContents);
+
+    // Second pass, applied on top of the first one.
+
+    pxr::ReplacementStore DisambiguateSymbolsStore;
+    if (
+        int Result = runPass(
+            "disambiguate-symbols",
+            OptionsParser.getCompilations(),
+            [](
+                pxr::ReplacementStore *Store,
+                pxr::MatcherRegistry *Registry
+            )
+            {
+                auto PxrTool
+                    = std::make_unique<
+                        pxr::disambiguate_symbols::DisambiguateSymbolsTool
+                    >(Store, Root);
+                PxrTool->registerMatchers(Registry);
+                return PxrTool;
+            },
+            pxr::disambiguate_symbols::DisambiguateSymbolsTool
+                ::mayHaveReplacements,
+            CommonOptions,
+            FileSystems,
+            DisambiguateSymbolsSources,
+            &DisambiguateSymbolsStore
+        )
+    )
+    {
+        return Result;
+    }
+
+    // The second pass changes the contents that the overlays refer to.
+
+    std::map<std::string, std::string> DisambiguateSymbolsContents;
+    if (
+        !pxr::applyReplacements(
+            DisambiguateSymbolsStore.getFileToReplacements(),
+            *FileSystems(),
+            &DisambiguateSymbolsContents
+        )
+    )
+    {
+        return 1;
+    }
+
+    for (auto &FileAndContent : DisambiguateSymbolsContents)
+    {
+        FileToContent[FileAndContent.first] = std::move(FileAndContent.second);
+    }
+
+    // The replacements of the second pass refer to the content left by
+    // the first one, so each file is exported as a single replacement of its
+    // whole content instead. These can't be merged with the replacements
+    // exported by another run changing the same files.
+
+    if (!CommonOptions.ExportPath.empty())
+    {
+        std::map<std::string, clang::tooling::Replacements> FileToReplacements;
+        for (const auto &FileAndContent : FileToContent)
+        {
+            const std::string &FilePath = FileAndContent.first;
+
+            llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+                = llvm::MemoryBuffer::getFile(FilePath);
+            if (!Buffer)
+            {
+                llvm::errs()
+                    << "Failed reading the file "
+                    << FilePath
+                    << ": "
+                    << Buffer.getError().message()
+                    << ".\n";
+                return 1;
+            }
+
+            llvm::Error Error = FileToReplacements[FilePath].add(
+                clang::tooling::Replacement(
+                    FilePath,
+                    0,
+                    (*Buffer)->getBufferSize(),
+                    FileAndContent.second
+                )
+            );
+            if (Error)
+            {
+                llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+                return 1;
+            }
+        }
+
+        if (
+            !pxr::exportReplacements(
+                CommonOptions.ExportPath, "", FileToReplacements
+            )
+        )
+        {
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (Dump)
+    {
+        pxr::dumpFiles(FileToContent, llvm::outs());
+    }
+
+    if (Overwrite && !pxr::writeFiles(FileToContent))
+    {
+        return 1;
+    }
+
+    return 0;
+}
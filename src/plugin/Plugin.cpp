@@ -0,0 +1,426 @@
+// Run the ‘inline-namespaces’ and ‘disambiguate-symbols’ tools from within
+// the compiler, as a plugin loaded with ‘-fplugin’, to find the replacements
+// while the sources are being compiled rather than parsing them once more.
+//
+// Each translation unit exports its replacements to its own file in
+// the directory given with the ‘export-dir’ argument, to be merged and applied
+// with ‘clang-apply-replacements’ once the build is done.
+//
+// Usage:
+//   clang++ -fplugin=libpxr-refactor.so
+//       -Xclang -plugin-arg-pxr-inline-namespaces
+//       -Xclang export-dir=<directory>
+//       -Xclang -plugin-arg-pxr-inline-namespaces
+//       -Xclang file-pattern=<pattern>
+//       ...
+//
+// The ‘inline-namespaces’ tool also accepts any number of ‘policy=<file>’
+// arguments, with more rules deciding which namespaces to inline.
+
+#include "../Export.h"
+#include "../FileScope.h"
+#include "../FilePattern.h"
+#include "../MatcherRegistry.h"
+#include "../ReplacementStore.h"
+#include "../TraversalScope.h"
+#include "../disambiguate-symbols/DisambiguateSymbols.h"
+#include "../inline-namespaces/InlineNamespaces.h"
+#include "../inline-namespaces/NamespacePolicy.h"
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/ASTContext.h>
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/FileEntry.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/FrontendPluginRegistry.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/* Consumer                                                        O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Find the replacements of a translation unit with the match callback of
+// a tool, then export them.
+
+class ExportConsumer
+    : public clang::ASTConsumer
+{
+public:
+    ExportConsumer(
+        std::string Directory
+    ) :
+        Directory(std::move(Directory)),
+        Registry(&this->Finder, &this->Scope, false)
+    {
+        // The build output is no place to describe each replacement.
+
+        this->Store.setDiagnosticsEnabled(false);
+    }
+
+    // Callback of the tool, to create with the store and the registry of
+    // this consumer, along with any data that it refers to.
+
+    void
+    setCallback(
+        std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>
+            Callback,
+        std::shared_ptr<const void> Data
+    )
+    {
+        this->Callback = std::move(Callback);
+        this->Data = std::move(Data);
+        this->Consumer = pxr::newMainFileScopeConsumer(
+            this->Finder.newASTConsumer(), &this->Scope
+        );
+    }
+
+    pxr::ReplacementStore *
+    getStore()
+    {
+        return &this->Store;
+    }
+
+    pxr::MatcherRegistry *
+    getRegistry()
+    {
+        return &this->Registry;
+    }
+
+    void
+    Initialize(
+        clang::ASTContext &Context
+    ) override
+    {
+        this->Consumer->Initialize(Context);
+    }
+
+    void
+    HandleTranslationUnit(
+        clang::ASTContext &Context
+    ) override
+    {
+        // Replacements found in a source that doesn't compile can't be
+        // trusted.
+
+        if (Context.getDiagnostics().hasErrorOccurred())
+        {
+            return;
+        }
+
+        this->Consumer->HandleTranslationUnit(Context);
+        this->Store.reportConflicts(llvm::errs());
+
+        const clang::SourceManager &SourceMgr = Context.getSourceManager();
+        const clang::FileEntry *MainFile
+            = SourceMgr.getFileEntryForID(SourceMgr.getMainFileID());
+        if (MainFile == nullptr)
+        {
+            return;
+        }
+
+        llvm::StringRef MainPath = MainFile->tryGetRealPathName();
+        if (MainPath.empty())
+        {
+            MainPath = MainFile->getName();
+        }
+
+        // Each source always writes to the same file, and removes it when it
+        // has nothing to export, so that rebuilding a source replaces its
+        // previous replacements.
+
+        std::string Key = llvm::toHex(
+            llvm::SHA1::hash(llvm::arrayRefFromStringRef(MainPath)), true
+        );
+        llvm::SmallString<256> Path(this->Directory);
+        llvm::sys::path::append(Path, Key + ".yaml");
+
+        if (this->Store.empty())
+        {
+            llvm::sys::fs::remove(Path);
+            return;
+        }
+
+        pxr::exportReplacements(
+            Path, MainPath, this->Store.getFileToReplacements()
+        );
+    }
+
+private:
+    std::string Directory;
+
+    // Compiler processes can't share their claims on the headers, so only
+    // the main file of each translation unit is refactored.
+    pxr::FileScope Scope;
+
+    clang::ast_matchers::MatchFinder Finder;
+    pxr::MatcherRegistry Registry;
+    pxr::ReplacementStore Store;
+    std::shared_ptr<const void> Data;
+    std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback> Callback;
+    std::unique_ptr<clang::ASTConsumer> Consumer;
+};
+
+/* Actions                                                         O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Action running alongside the compilation, parsing the arguments common to
+// all the tools and leaving the others to the derived actions.
+
+class ExportAction
+    : public clang::PluginASTAction
+{
+public:
+    ActionType
+    getActionType() override
+    {
+        return AddBeforeMainAction;
+    }
+
+protected:
+    std::unique_ptr<clang::ASTConsumer>
+    CreateASTConsumer(
+        clang::CompilerInstance &CI,
+        llvm::StringRef InFile
+    ) override
+    {
+        auto Consumer = std::make_unique<ExportConsumer>(this->Directory);
+        std::shared_ptr<const void> Data;
+        Consumer->setCallback(
+            this->createCallback(
+                Consumer->getStore(), Consumer->getRegistry(), &Data
+            ),
+            std::move(Data)
+        );
+        return Consumer;
+    }
+
+    bool
+    ParseArgs(
+        const clang::CompilerInstance &CI,
+        const std::vector<std::string> &Args
+    ) override
+    {
+        for (const std::string &Arg : Args)
+        {
+            llvm::StringRef Name;
+            llvm::StringRef Value;
+            std::tie(Name, Value) = llvm::StringRef(Arg).split('=');
+            if (Name == "export-dir")
+            {
+                this->Directory = Value.str();
+            }
+            else if (!this->parseArg(Name, Value))
+            {
+                llvm::errs() << "Unknown plugin argument: " << Arg << ".\n";
+                return false;
+            }
+        }
+
+        if (this->Directory.empty())
+        {
+            llvm::errs() << "The plugin argument ‘export-dir’ is required.\n";
+            return false;
+        }
+
+        std::error_code Error
+            = llvm::sys::fs::create_directories(this->Directory);
+        if (Error)
+        {
+            llvm::errs()
+                << "Failed creating the directory "
+                << this->Directory
+                << ": "
+                << Error.message()
+                << ".\n";
+            return false;
+        }
+
+        return this->checkArgs();
+    }
+
+    virtual bool
+    parseArg(
+        llvm::StringRef Name,
+        llvm::StringRef Value
+    ) = 0;
+
+    virtual bool
+    checkArgs() = 0;
+
+    // The action is destroyed once its consumer is created, so any data that
+    // the callback refers to is to be handed over to the consumer.
+
+    virtual std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>
+    createCallback(
+        pxr::ReplacementStore *Store,
+        pxr::MatcherRegistry *Registry,
+        std::shared_ptr<const void> *Data
+    ) = 0;
+
+private:
+    std::string Directory;
+};
+
+class InlineNamespacesAction
+    : public ExportAction
+{
+protected:
+    bool
+    parseArg(
+        llvm::StringRef Name,
+        llvm::StringRef Value
+    ) override
+    {
+        if (Name == "policy")
+        {
+            this->PolicyPaths.push_back(Value.str());
+            return true;
+        }
+
+        if (Name != "file-pattern")
+        {
+            return false;
+        }
+
+        this->PatternText = Value.str();
+        return true;
+    }
+
+    bool
+    checkArgs() override
+    {
+        if (this->PatternText.empty())
+        {
+            llvm::errs()
+                << "The plugin argument ‘file-pattern’ is required.\n";
+            return false;
+        }
+
+        llvm::Expected<pxr::FilePattern> Pattern
+            = pxr::FilePattern::create(this->PatternText);
+        if (!Pattern)
+        {
+            llvm::errs() << llvm::toString(Pattern.takeError()) << "\n";
+            return false;
+        }
+
+        this->Pattern = std::make_unique<pxr::FilePattern>(
+            std::move(*Pattern)
+        );
+
+        for (const std::string &Path : this->PolicyPaths)
+        {
+            if (llvm::Error Error = this->Policy.parseFile(Path))
+            {
+                llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>
+    createCallback(
+        pxr::ReplacementStore *Store,
+        pxr::MatcherRegistry *Registry,
+        std::shared_ptr<const void> *Data
+    ) override
+    {
+        auto PxrTool
+            = std::make_unique<pxr::inline_namespaces::InlineNamespacesTool>(
+                Store, *this->Pattern, this->Policy
+            );
+        PxrTool->registerMatchers(Registry);
+        return PxrTool;
+    }
+
+private:
+    std::string PatternText;
+    std::unique_ptr<pxr::FilePattern> Pattern;
+    std::vector<std::string> PolicyPaths;
+    pxr::inline_namespaces::NamespacePolicy Policy
+        = pxr::inline_namespaces::NamespacePolicy::getDefault();
+};
+
+class DisambiguateSymbolsAction
+    : public ExportAction
+{
+protected:
+    bool
+    parseArg(
+        llvm::StringRef Name,
+        llvm::StringRef Value
+    ) override
+    {
+        if (Name != "root")
+        {
+            return false;
+        }
+
+        this->Root = Value.str();
+        return true;
+    }
+
+    bool
+    checkArgs() override
+    {
+        return true;
+    }
+
+    std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>
+    createCallback(
+        pxr::ReplacementStore *Store,
+        pxr::MatcherRegistry *Registry,
+        std::shared_ptr<const void> *Data
+    ) override
+    {
+        // The tool only keeps a reference to the root path.
+
+        auto Root = std::make_shared<const std::string>(this->Root);
+        auto PxrTool
+            = std::make_unique<pxr::disambiguate_symbols::DisambiguateSymbolsTool>(
+                Store, *Root
+            );
+        *Data = std::move(Root);
+        PxrTool->registerMatchers(Registry);
+        return PxrTool;
+    }
+
+private:
+    std::string Root;
+};
+
+/* Registration                                                    O-(''Q)
+   -------------------------------------------------------------------------- */
+
+clang::FrontendPluginRegistry::Add<InlineNamespacesAction>
+    InlineNamespacesPlugin(
+        "pxr-inline-namespaces",
+        "Export the replacements of the ‘inline-namespaces’ tool."
+    );
+
+clang::FrontendPluginRegistry::Add<DisambiguateSymbolsAction>
+    DisambiguateSymbolsPlugin(
+        "pxr-disambiguate-symbols",
+        "Export the replacements of the ‘disambiguate-symbols’ tool."
+    );
+
+} // anonymous namespace
@@ -0,0 +1,632 @@
+// Run the tools over the fixtures of the ‘tests’ directory within a single
+// process, and compare the result with the expected content.
+//
+// Each directory ‘tests/<tool>/<test>’ holds a source ‘original.cpp’ and
+// the content ‘expected.cpp’ that the tool is expected to turn it into.
+// It can also hold a header ‘header/original.h’, with its expected content
+// ‘header/expected.h’, that the source includes and refactors rather than
+// the header being parsed on its own, and a ‘policy.txt’ with more rules
+// deciding which namespaces to inline, on top of the default ones.
+// The fixtures of a tool are all processed in parallel by a single executor,
+// and the replacements are applied in memory.
+//
+// The fixtures that don't include USD's headers are self-contained, and are
+// always parsed as plain C++17. The other ones are parsed with the flags
+// inferred from the compilation database found with ‘-p’, or with the ones
+// given after ‘--’, such as the include paths to USD's headers and to its
+// dependencies. Without either, they are skipped, and the run fails.
+
+#include "../../Apply.h"
+#include "../../Executor.h"
+#include "../../FilePattern.h"
+#include "../../MatcherRegistry.h"
+#include "../../ReplacementStore.h"
+#include "../../disambiguate-symbols/DisambiguateSymbols.h"
+#include "../../inline-namespaces/InlineNamespaces.h"
+#include "../../inline-namespaces/NamespacePolicy.h"
+
+#include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Signals.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+
+llvm::cl::OptionCategory TestFixturesCategory("Test Fixtures");
+
+llvm::cl::opt<std::string> TestsDir(
+    "tests-dir",
+    llvm::cl::desc("Directory holding the fixtures of each tool."),
+    llvm::cl::init(PXR_TESTS_DIR),
+    llvm::cl::cat(TestFixturesCategory)
+);
+
+llvm::cl::list<std::string> ToolNames(
+    "tool",
+    llvm::cl::desc("Only run the fixtures of the given tool."),
+    llvm::cl::ZeroOrMore,
+    llvm::cl::cat(TestFixturesCategory)
+);
+
+llvm::cl::list<std::string> TestNames(
+    "test",
+    llvm::cl::desc("Only run the fixtures of the given name."),
+    llvm::cl::ZeroOrMore,
+    llvm::cl::cat(TestFixturesCategory)
+);
+
+llvm::cl::opt<unsigned> Jobs(
+    "j",
+    llvm::cl::desc("Number of fixtures to process in parallel (0: all cores)."),
+    llvm::cl::init(0),
+    llvm::cl::cat(TestFixturesCategory)
+);
+
+struct Fixture
+{
+    std::string Name;
+    std::string Original;
+    std::string Expected;
+
+    // Header refactored from within the source, if any.
+    std::string OriginalHeader;
+    std::string ExpectedHeader;
+
+    // Rules of the namespace policy, if any.
+    std::string Policy;
+};
+
+const llvm::StringRef Tools[] = {
+    "inline-namespaces",
+    "disambiguate-symbols",
+};
+
+/* Fixtures                                                        O-(''Q)
+   -------------------------------------------------------------------------- */
+
+bool
+isSelected(
+    const llvm::cl::list<std::string> &Names,
+    llvm::StringRef Name
+)
+{
+    return Names.empty() || llvm::is_contained(Names, Name);
+}
+
+bool
+findFixtures(
+    llvm::StringRef ToolDir,
+    std::vector<Fixture> *Out
+)
+{
+    std::error_code Error;
+    for (
+        llvm::sys::fs::directory_iterator It(ToolDir, Error), End;
+        It != End && !Error;
+        It.increment(Error)
+    )
+    {
+        llvm::StringRef Name = llvm::sys::path::filename(It->path());
+        if (
+            It->type() != llvm::sys::fs::file_type::directory_file
+            || !isSelected(TestNames, Name)
+        )
+        {
+            continue;
+        }
+
+        llvm::SmallString<256> Original(It->path());
+        llvm::sys::path::append(Original, "original.cpp");
+
+        llvm::SmallString<256> Expected(It->path());
+        llvm::sys::path::append(Expected, "expected.cpp");
+
+        Out->emplace_back();
+        Out->back().Name = Name.str();
+        Out->back().Original = Original.str().str();
+        Out->back().Expected = Expected.str().str();
+
+        llvm::SmallString<256> OriginalHeader(It->path());
+        llvm::sys::path::append(OriginalHeader, "header", "original.h");
+        if (llvm::sys::fs::exists(OriginalHeader))
+        {
+            llvm::SmallString<256> ExpectedHeader(It->path());
+            llvm::sys::path::append(ExpectedHeader, "header", "expected.h");
+            Out->back().OriginalHeader = OriginalHeader.str().str();
+            Out->back().ExpectedHeader = ExpectedHeader.str().str();
+        }
+
+        llvm::SmallString<256> Policy(It->path());
+        llvm::sys::path::append(Policy, "policy.txt");
+        if (llvm::sys::fs::exists(Policy))
+        {
+            Out->back().Policy = Policy.str().str();
+        }
+    }
+
+    if (Error)
+    {
+        llvm::errs()
+            << "Failed listing the fixtures in "
+            << ToolDir
+            << ": "
+            << Error.message()
+            << ".\n";
+        return false;
+    }
+
+    std::sort(
+        Out->begin(),
+        Out->end(),
+        [](const Fixture &A, const Fixture &B)
+        {
+            return A.Name < B.Name;
+        }
+    );
+    return true;
+}
+
+bool
+readFile(
+    llvm::StringRef Path,
+    std::string *Out
+)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer
+        = llvm::MemoryBuffer::getFile(Path);
+    if (!Buffer)
+    {
+        llvm::errs()
+            << "Failed reading the file "
+            << Path
+            << ": "
+            << Buffer.getError().message()
+            << ".\n";
+        return false;
+    }
+
+    *Out = (*Buffer)->getBuffer().str();
+    return true;
+}
+
+// Whether the fixture includes USD's headers, which can't be found without the
+// compile flags of its build.
+
+bool
+includesUsd(
+    const Fixture &Fixture
+)
+{
+    for (
+        const std::string *Path : {&Fixture.Original, &Fixture.OriginalHeader}
+    )
+    {
+        std::string Content;
+        if (Path->empty() || !readFile(*Path, &Content))
+        {
+            continue;
+        }
+
+        llvm::SmallVector<llvm::StringRef> Lines;
+        llvm::StringRef(Content).split(Lines, '\n');
+        for (llvm::StringRef Line : Lines)
+        {
+            Line = Line.trim();
+            if (
+                Line.consume_front("#")
+                && Line.ltrim().startswith("include")
+                && (Line.contains("<pxr/") || Line.contains("\"pxr/"))
+            )
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Report the first line that differs between both contents, if any.
+
+bool
+compareContents(
+    llvm::StringRef Name,
+    llvm::StringRef Tool,
+    llvm::StringRef Actual,
+    llvm::StringRef Expected
+)
+{
+    llvm::SmallVector<llvm::StringRef> ActualLines;
+    llvm::SmallVector<llvm::StringRef> ExpectedLines;
+    Actual.rtrim().split(ActualLines, '\n');
+    Expected.rtrim().split(ExpectedLines, '\n');
+
+    size_t Count = std::max(ActualLines.size(), ExpectedLines.size());
+    for (size_t I = 0; I < Count; ++I)
+    {
+        llvm::StringRef ActualLine
+            = I < ActualLines.size() ? ActualLines[I] : "<end of file>";
+        llvm::StringRef ExpectedLine
+            = I < ExpectedLines.size() ? ExpectedLines[I] : "<end of file>";
+        if (ActualLine == ExpectedLine)
+        {
+            continue;
+        }
+
+        llvm::errs()
+            << "Test ‘" << Name << "’ (" << Tool << ") differs at line "
+            << I + 1 << ":\n"
+            << "  expected: " << ExpectedLine << "\n"
+            << "  actual:   " << ActualLine << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Compare the content that the tool left in the given file with the expected
+// one, and return 1 if they match, 0 if they don't, or -1 on failure.
+// The replaced files are keyed on their real path, since the sources can
+// include them through symbolic links.
+
+int
+compareFile(
+    llvm::StringRef Name,
+    llvm::StringRef Tool,
+    const std::map<std::string, std::string> &FileToContent,
+    llvm::StringRef Original,
+    llvm::StringRef Expected
+)
+{
+    // The files left untouched aren't part of the results.
+
+    llvm::SmallString<256> Path;
+    if (llvm::sys::fs::real_path(Original, Path))
+    {
+        Path = Original;
+    }
+
+    std::string Actual;
+    auto It = FileToContent.find(Path.str().str());
+    if (It != FileToContent.end())
+    {
+        Actual = It->second;
+    }
+    else if (!readFile(Original, &Actual))
+    {
+        return -1;
+    }
+
+    std::string ExpectedContent;
+    if (!readFile(Expected, &ExpectedContent))
+    {
+        return -1;
+    }
+
+    return compareContents(Name, Tool, Actual, ExpectedContent) ? 1 : 0;
+}
+
+/* Runs                                                            O-(''Q)
+   -------------------------------------------------------------------------- */
+
+// Process the fixtures of a tool sharing the same policy file, if any, and
+// return the number of them that passed, or -1 on failure.
+
+int
+runFixtures(
+    llvm::StringRef Tool,
+    const clang::tooling::CompilationDatabase &Compilations,
+    llvm::StringRef ToolDir,
+    llvm::StringRef PolicyPath,
+    const std::vector<Fixture> &Fixtures
+)
+{
+    pxr::ExecutorOptions Options;
+    Options.Jobs = Jobs;
+    Options.HeadersFromIncluders = true;
+
+    // The fixtures are the files to refactor, and their directory is the root
+    // that the modules are named after.
+
+    std::string Root = ToolDir.str();
+    llvm::Expected<pxr::FilePattern> Pattern
+        = pxr::FilePattern::create(Root + "/*");
+    if (!Pattern)
+    {
+        llvm::errs() << llvm::toString(Pattern.takeError()) << "\n";
+        return -1;
+    }
+
+    pxr::inline_namespaces::NamespacePolicy Policy
+        = pxr::inline_namespaces::NamespacePolicy::getDefault();
+    if (!PolicyPath.empty())
+    {
+        if (llvm::Error Error = Policy.parseFile(PolicyPath))
+        {
+            llvm::errs() << llvm::toString(std::move(Error)) << "\n";
+            return -1;
+        }
+    }
+
+    pxr::CallbackFactory Factory;
+    if (Tool == "inline-namespaces")
+    {
+        Factory = [&Pattern, &Policy](
+            pxr::ReplacementStore *Store,
+            pxr::MatcherRegistry *Registry
+        )
+        {
+            auto PxrTool = std::make_unique<
+                pxr::inline_namespaces::InlineNamespacesTool
+            >(Store, *Pattern, Policy);
+            PxrTool->registerMatchers(Registry);
+            return PxrTool;
+        };
+    }
+    else
+    {
+        Factory = [&Root](
+            pxr::ReplacementStore *Store,
+            pxr::MatcherRegistry *Registry
+        )
+        {
+            auto PxrTool = std::make_unique<
+                pxr::disambiguate_symbols::DisambiguateSymbolsTool
+            >(Store, Root);
+            PxrTool->registerMatchers(Registry);
+            return PxrTool;
+        };
+    }
+
+    pxr::Executor Executor(Compilations, Factory, Options);
+
+    std::vector<std::string> SourcePaths;
+    for (const Fixture &Fixture : Fixtures)
+    {
+        SourcePaths.push_back(Fixture.Original);
+        if (!Fixture.OriginalHeader.empty())
+        {
+            SourcePaths.push_back(Fixture.OriginalHeader);
+        }
+    }
+
+    pxr::ReplacementStore Store;
+    Store.setDiagnosticsEnabled(false);
+    if (Executor.run(SourcePaths, &Store))
+    {
+        return -1;
+    }
+
+    Store.reportConflicts(llvm::errs());
+
+    std::map<std::string, std::string> Contents;
+    if (
+        !pxr::applyReplacements(
+            Store.getFileToReplacements(),
+            *llvm::vfs::getRealFileSystem(),
+            &Contents
+        )
+    )
+    {
+        return -1;
+    }
+
+    std::map<std::string, std::string> FileToContent;
+    for (auto &FileAndContent : Contents)
+    {
+        llvm::SmallString<256> Path;
+        if (llvm::sys::fs::real_path(FileAndContent.first, Path))
+        {
+            Path = FileAndContent.first;
+        }
+
+        FileToContent[Path.str().str()] = std::move(FileAndContent.second);
+    }
+
+    int Out = 0;
+    for (const Fixture &Fixture : Fixtures)
+    {
+        int Result = compareFile(
+            Fixture.Name,
+            Tool,
+            FileToContent,
+            Fixture.Original,
+            Fixture.Expected
+        );
+        if (Result > 0 && !Fixture.OriginalHeader.empty())
+        {
+            Result = compareFile(
+                Fixture.Name,
+                Tool,
+                FileToContent,
+                Fixture.OriginalHeader,
+                Fixture.ExpectedHeader
+            );
+        }
+
+        if (Result < 0)
+        {
+            return -1;
+        }
+
+        Out += Result;
+    }
+
+    return Out;
+}
+
+// Whether the command line gives the compile flags, either with the build
+// directory holding a compilation database, or after ‘--’.
+
+bool
+hasCompileFlags(
+    int argc,
+    const char **argv
+)
+{
+    for (int I = 1; I < argc; ++I)
+    {
+        llvm::StringRef Argument(argv[I]);
+        if (Argument == "--")
+        {
+            return true;
+        }
+
+        if (Argument.consume_front("-"))
+        {
+            Argument.consume_front("-");
+            if (Argument == "p" || Argument.startswith("p="))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+} // anonymous namespace
+
+int
+main(
+    int argc,
+    const char **argv
+)
+{
+    llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+    // The fixtures are found in the tests directory rather than given on
+    // the command line. The flags are only needed by the fixtures including
+    // USD's headers, so empty ones are given when there are none for the
+    // options to parse.
+
+    bool HasCompileFlags = hasCompileFlags(argc, argv);
+    std::vector<const char *> Arguments(argv, argv + argc);
+    if (!HasCompileFlags)
+    {
+        Arguments.push_back("--");
+    }
+
+    int ArgumentCount = int(Arguments.size());
+    auto ExpectedParser = clang::tooling::CommonOptionsParser::create(
+        ArgumentCount,
+        Arguments.data(),
+        TestFixturesCategory,
+        llvm::cl::ZeroOrMore
+    );
+    if (!ExpectedParser)
+    {
+        llvm::errs() << ExpectedParser.takeError();
+        return 1;
+    }
+
+    clang::tooling::CommonOptionsParser &OptionsParser = ExpectedParser.get();
+    clang::tooling::FixedCompilationDatabase SelfContained(
+        ".", std::vector<std::string>{"-std=c++17"}
+    );
+
+    size_t Passed = 0;
+    size_t Total = 0;
+    size_t Skipped = 0;
+    for (llvm::StringRef Tool : Tools)
+    {
+        if (!isSelected(ToolNames, Tool))
+        {
+            continue;
+        }
+
+        llvm::SmallString<256> ToolDir(TestsDir);
+        llvm::sys::fs::make_absolute(ToolDir);
+        llvm::sys::path::append(ToolDir, Tool);
+        if (!llvm::sys::fs::is_directory(ToolDir))
+        {
+            continue;
+        }
+
+        std::vector<Fixture> Fixtures;
+        if (!findFixtures(ToolDir, &Fixtures))
+        {
+            return 1;
+        }
+
+        if (Fixtures.empty())
+        {
+            continue;
+        }
+
+        // Each policy needs a run of its own, and so does each set of
+        // compile flags, keyed on whether the fixtures include USD's headers.
+
+        std::map<std::pair<bool, std::string>, std::vector<Fixture>> Runs;
+        for (Fixture &Fixture : Fixtures)
+        {
+            bool IncludesUsd = includesUsd(Fixture);
+            if (IncludesUsd && !HasCompileFlags)
+            {
+                llvm::outs()
+                    << "Test ‘" << Fixture.Name << "’ (" << Tool << ") "
+                    << "skipped, since it includes USD's headers and no "
+                    << "compile flags were given.\n";
+                ++Skipped;
+                continue;
+            }
+
+            Runs[{IncludesUsd, Fixture.Policy}].push_back(std::move(Fixture));
+        }
+
+        for (const auto &KeyAndFixtures : Runs)
+        {
+            int Result = runFixtures(
+                Tool,
+                KeyAndFixtures.first.first
+                    ? OptionsParser.getCompilations()
+                    : SelfContained,
+                ToolDir,
+                KeyAndFixtures.first.second,
+                KeyAndFixtures.second
+            );
+            if (Result < 0)
+            {
+                return 1;
+            }
+
+            Passed += size_t(Result);
+            Total += KeyAndFixtures.second.size();
+        }
+    }
+
+    llvm::outs() << Passed << " of " << Total << " tests passed";
+    if (Skipped)
+    {
+        llvm::outs() << ", " << Skipped << " skipped";
+    }
+
+    llvm::outs() << ".\n";
+
+    // The skipped fixtures fail the run, for it not to pass without having
+    // checked them.
+
+    return Passed == Total && !Skipped ? 0 : 1;
+}
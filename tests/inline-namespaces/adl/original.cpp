@@ -0,0 +1,14 @@
+#include <sstream>
+#include <string>
+
+int
+main()
+{
+    std::istringstream in("hello");
+    std::string s;
+
+    // Found through ADL, with nothing in this file hinting at it.
+    getline(in, s);
+
+    return s.empty();
+}
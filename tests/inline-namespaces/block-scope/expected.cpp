@@ -0,0 +1,40 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+
+void
+inside()
+{
+    {
+        using namespace foo;
+
+        bar::S a;
+        bar::f();
+        (void)a;
+    }
+
+    foo::bar::S b;
+    foo::bar::f();
+    (void)b;
+}
+
+void
+outside()
+{
+    foo::bar::S c;
+    (void)c;
+}
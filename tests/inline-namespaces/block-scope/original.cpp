@@ -0,0 +1,41 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+using namespace foo::bar;
+
+void
+inside()
+{
+    {
+        using namespace foo;
+
+        S a;
+        f();
+        (void)a;
+    }
+
+    S b;
+    f();
+    (void)b;
+}
+
+void
+outside()
+{
+    S c;
+    (void)c;
+}
@@ -0,0 +1,5 @@
+inline std::string
+greet()
+{
+    return "hello";
+}
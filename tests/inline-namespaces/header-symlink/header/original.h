@@ -0,0 +1,5 @@
+inline string
+greet()
+{
+    return "hello";
+}
@@ -0,0 +1,14 @@
+#include <string>
+
+using namespace std;
+
+// The header is listed as ‘header/original.h’ but included through
+// a symbolic link, and can only be parsed from within this file.
+#include "link/original.h"
+
+int
+main()
+{
+    string s = greet();
+    return s.empty();
+}
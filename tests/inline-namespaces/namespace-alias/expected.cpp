@@ -0,0 +1,19 @@
+namespace foo
+{
+namespace bar
+{
+namespace baz
+{
+
+struct S
+{
+};
+
+} // namespace baz
+} // namespace bar
+} // namespace foo
+
+namespace fb = foo::bar;
+
+
+fb::baz::S a;
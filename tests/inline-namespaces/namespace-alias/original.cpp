@@ -0,0 +1,20 @@
+namespace foo
+{
+namespace bar
+{
+namespace baz
+{
+
+struct S
+{
+};
+
+} // namespace baz
+} // namespace bar
+} // namespace foo
+
+namespace fb = foo::bar;
+
+using namespace foo::bar::baz;
+
+S a;
@@ -0,0 +1,17 @@
+namespace foo
+{
+namespace detail
+{
+
+struct S
+{
+};
+
+} // namespace detail
+
+using namespace detail;
+
+} // namespace foo
+
+
+foo::S a;
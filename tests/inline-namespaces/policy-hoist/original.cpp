@@ -0,0 +1,18 @@
+namespace foo
+{
+namespace detail
+{
+
+struct S
+{
+};
+
+} // namespace detail
+
+using namespace detail;
+
+} // namespace foo
+
+using namespace foo;
+
+S a;
@@ -0,0 +1,19 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+struct T
+{
+};
+
+} // namespace bar
+} // namespace foo
+
+
+foo::bar::S a;
+foo::bar::T b;
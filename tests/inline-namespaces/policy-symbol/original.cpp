@@ -0,0 +1,20 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+struct T
+{
+};
+
+} // namespace bar
+} // namespace foo
+
+using namespace foo;
+
+bar::S a;
+foo::bar::T b;
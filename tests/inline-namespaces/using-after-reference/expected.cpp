@@ -0,0 +1,23 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+
+foo::bar::S a;
+
+using namespace foo;
+
+bar::S b;
@@ -0,0 +1,24 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+using namespace foo::bar;
+
+S a;
+
+using namespace foo;
+
+S b;
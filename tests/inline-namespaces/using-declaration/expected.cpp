@@ -0,0 +1,31 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+
+void
+before()
+{
+    foo::bar::f();
+}
+
+using foo::bar::f;
+
+void
+after()
+{
+    f();
+}
@@ -0,0 +1,32 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+using namespace foo::bar;
+
+void
+before()
+{
+    f();
+}
+
+using foo::bar::f;
+
+void
+after()
+{
+    f();
+}
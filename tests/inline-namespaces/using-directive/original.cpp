@@ -0,0 +1,21 @@
+namespace foo
+{
+namespace bar
+{
+
+struct S
+{
+};
+
+void
+f()
+{
+}
+
+} // namespace bar
+} // namespace foo
+
+using namespace foo;
+using namespace foo::bar;
+
+S a;
@@ -0,0 +1,500 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Measure the throughput of the refactoring tools over a synthetic tree.
+
+The tree mimics the layout of USD: modules of sources and headers opening
+the ‘pxr’ namespace, that include third-party headers with nested namespaces
+and templates, refer to their symbols through ‘using’ directives and
+declarations, and define helpers within anonymous namespaces.
+
+The third-party namespace is inlined through a policy written along with
+the tree, and the tree is only generated again when its parameters change,
+so that consecutive runs are comparable.
+"""
+
+from argparse import ArgumentParser
+import json
+from os import (
+    makedirs,
+    pardir,
+    wait4,
+    waitstatus_to_exitcode,
+)
+from os.path import (
+    abspath,
+    dirname,
+    isfile,
+    join,
+)
+from random import Random
+from shutil import rmtree
+from statistics import median
+from subprocess import (
+    DEVNULL,
+    Popen,
+)
+from tempfile import TemporaryDirectory
+from time import perf_counter
+
+
+ROOT_DIR = abspath(join(dirname(__file__), pardir))
+BUILD_DIR = join(ROOT_DIR, "build")
+EXECUTABLE_DIR = join(BUILD_DIR, "bin")
+BENCHMARK_DIR = join(BUILD_DIR, "benchmark")
+
+FILES_PER_MODULE = 16
+FILES_PER_LIBRARY = 8
+
+TEMPLATE_HEADERS = (
+    "map",
+    "functional",
+    "memory",
+    "unordered_map",
+    "vector",
+    "tuple",
+    "string",
+    "algorithm",
+    "regex",
+    "variant",
+)
+
+PXR_HEADER = """\
+#ifndef PXR_H
+#define PXR_H
+
+#define PXR_NS pxr
+#define PXR_INTERNAL_NS pxrInternal_v0_0__pxrReserved__
+#define PXR_NAMESPACE_OPEN_SCOPE namespace PXR_INTERNAL_NS {
+#define PXR_NAMESPACE_CLOSE_SCOPE }
+#define PXR_NAMESPACE_USING_DIRECTIVE using namespace PXR_NS;
+
+namespace PXR_INTERNAL_NS { }
+
+namespace PXR_NS {
+    using namespace PXR_INTERNAL_NS;
+}
+
+#endif
+"""
+
+POLICY = """\
+inline synth
+"""
+
+
+def get_library_namespace(index, depth):
+    return ["synth", "lib{}".format(index)] + [
+        "n{}".format(i) for i in range(1, depth - 1)
+    ]
+
+
+def make_library(index, depth, includes):
+    namespace = get_library_namespace(index, depth)
+    lines = []
+    lines.append("#ifndef SYNTH_LIB{}_H".format(index))
+    lines.append("#define SYNTH_LIB{}_H".format(index))
+    lines.append("")
+    lines.extend("#include <{}>".format(x) for x in includes)
+    lines.append("")
+    lines.extend("namespace {} {{".format(x) for x in namespace)
+    lines.append("")
+    lines.append("template <typename T>")
+    lines.append("struct Box{}".format(index))
+    lines.append("{")
+    lines.append("    std::vector<std::map<int, T>> Values;")
+    lines.append("};")
+    lines.append("")
+    lines.append("template <typename T>")
+    lines.append("Box{}<T>".format(index))
+    lines.append("makeBox{}(T Value)".format(index))
+    lines.append("{")
+    lines.append("    Box{}<T> Out;".format(index))
+    lines.append("    Out.Values.push_back({{0, Value}});")
+    lines.append("    return Out;")
+    lines.append("}")
+    lines.append("")
+    lines.append("inline int")
+    lines.append("count{}(int Value)".format(index))
+    lines.append("{")
+    lines.append("    return Value + {};".format(index))
+    lines.append("}")
+    lines.append("")
+    lines.extend("}} // namespace {}".format(x) for x in reversed(namespace))
+    lines.append("")
+    lines.append("#endif")
+    return "\n".join(lines) + "\n"
+
+
+def make_header(module, name, guard):
+    lines = []
+    lines.append("#ifndef {}".format(guard))
+    lines.append("#define {}".format(guard))
+    lines.append("")
+    lines.append('#include "pxr/pxr.h"')
+    lines.append("")
+    lines.append("PXR_NAMESPACE_OPEN_SCOPE")
+    lines.append("")
+    lines.append("int")
+    lines.append("{}_{}Compute(int Value);".format(module, name))
+    lines.append("")
+    lines.append("PXR_NAMESPACE_CLOSE_SCOPE")
+    lines.append("")
+    lines.append("#endif")
+    return "\n".join(lines) + "\n"
+
+
+def make_source(module, name, libraries, depth, random, params):
+    lines = []
+    lines.append('#include "pxr/pxr.h"')
+    lines.append('#include "pxr/{}/{}.h"'.format(module, name))
+    lines.extend('#include "synth/lib{}.h"'.format(x) for x in libraries)
+    lines.append("")
+    lines.extend(
+        "#include <{}>".format(x)
+        for x in TEMPLATE_HEADERS[:params["template_includes"]]
+    )
+    lines.append("")
+    lines.append("PXR_NAMESPACE_OPEN_SCOPE")
+    lines.append("")
+
+    # Refer to the symbols of each library either through a directive,
+    # through declarations, or with their full namespace.
+
+    prefixes = {}
+    for index in libraries:
+        namespace = "::".join(get_library_namespace(index, depth))
+        if random.random() >= params["using_density"]:
+            prefixes[index] = namespace + "::"
+        elif random.random() < 0.5:
+            lines.append("using namespace {};".format(namespace))
+            prefixes[index] = ""
+        else:
+            lines.append("using {}::count{};".format(namespace, index))
+            lines.append("using {}::makeBox{};".format(namespace, index))
+            prefixes[index] = ""
+
+    lines.append("")
+
+    helpers = params["anonymous_symbols"]
+    if helpers:
+        lines.append("namespace {")
+        lines.append("")
+        for i in range(helpers):
+            lines.append("int")
+            lines.append("_Helper{}(int Value)".format(i))
+            lines.append("{")
+            lines.append("    return Value * {};".format(i + 2))
+            lines.append("}")
+            lines.append("")
+
+        lines.append("} // anonymous namespace")
+        lines.append("")
+
+    lines.append("int")
+    lines.append("{}_{}Compute(int Value)".format(module, name))
+    lines.append("{")
+    lines.append("    int Out = Value;")
+    for index in libraries:
+        prefix = prefixes[index]
+        lines.append("    Out += {}count{}(Out);".format(prefix, index))
+        lines.append(
+            "    Out += int({}makeBox{}(Out).Values.size());".format(
+                prefix, index
+            )
+        )
+
+    for i in range(helpers):
+        lines.append("    Out += _Helper{}(Out);".format(i))
+
+    lines.append("    return Out;")
+    lines.append("}")
+    lines.append("")
+    lines.append("PXR_NAMESPACE_CLOSE_SCOPE")
+    return "\n".join(lines) + "\n"
+
+
+def write_file(path, content):
+    makedirs(dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8") as file:
+        file.write(content)
+
+
+def generate(path, params):
+    """Generate the tree, unless it was already with the same parameters."""
+    params_path = join(path, "params.json")
+    sources_path = join(path, "sources.json")
+    if isfile(params_path) and isfile(sources_path):
+        with open(params_path, "r", encoding="utf-8") as file:
+            if json.load(file) == params:
+                with open(sources_path, "r", encoding="utf-8") as file:
+                    return json.load(file)
+
+    rmtree(path, ignore_errors=True)
+    random = Random(params["seed"])
+    depth = max(2, params["depth"])
+    library_count = max(1, params["files"] // FILES_PER_LIBRARY)
+
+    write_file(join(path, "pxr", "pxr.h"), PXR_HEADER)
+    write_file(join(path, "policy.txt"), POLICY)
+
+    for index in range(library_count):
+        includes = sorted(
+            set(("map", "vector"))
+            | set(TEMPLATE_HEADERS[:params["template_includes"]])
+        )
+        write_file(
+            join(path, "synth", "lib{}.h".format(index)),
+            make_library(index, depth, includes),
+        )
+
+    sources = []
+    entries = []
+    for i in range(params["files"]):
+        module = "mod{}".format(i // FILES_PER_MODULE)
+        name = "file{}".format(i)
+        libraries = sorted(
+            random.sample(range(library_count), min(3, library_count))
+        )
+
+        guard = "PXR_{}_{}_H".format(module.upper(), name.upper())
+        write_file(
+            join(path, "pxr", module, name + ".h"),
+            make_header(module, name, guard),
+        )
+
+        source_path = join(path, "pxr", module, name + ".cpp")
+        write_file(
+            source_path,
+            make_source(module, name, libraries, depth, random, params),
+        )
+
+        sources.append(source_path)
+        entries.append(
+            {
+                "directory": path,
+                "command": "clang++ -std=c++17 -I{} -c {} -o {}".format(
+                    path, source_path, source_path + ".o"
+                ),
+                "file": source_path,
+            }
+        )
+
+    write_file(
+        join(path, "compile_commands.json"), json.dumps(entries, indent=4)
+    )
+
+    with open(sources_path, "w", encoding="utf-8") as file:
+        json.dump(sources, file)
+
+    with open(params_path, "w", encoding="utf-8") as file:
+        json.dump(params, file)
+
+    return sources
+
+
+def run_tool(cmd):
+    """Run the command and return its wall time and peak RSS in MiB."""
+    start = perf_counter()
+    process = Popen(cmd, stdout=DEVNULL)
+    _, status, usage = wait4(process.pid, 0)
+    elapsed = perf_counter() - start
+
+    # The process is reaped by `wait4()`, which `Popen` doesn't know of.
+
+    process.returncode = waitstatus_to_exitcode(status)
+    if process.returncode:
+        raise RuntimeError("Failed running ‘{}’".format(" ".join(cmd)))
+
+    return elapsed, usage.ru_maxrss / 1024.0
+
+
+def benchmark(name, cmd, sources, repeat, cache_dir):
+    with TemporaryDirectory() as temp_dir:
+        report_path = join(temp_dir, "report.json")
+        tool_cmd = list(cmd)
+        tool_cmd.append("--report=json")
+        tool_cmd.extend(("--report-file", report_path))
+        tool_cmd.append("--profile-matchers")
+
+        if cache_dir:
+            # Populate the cache once for the runs measured to reuse it.
+
+            rmtree(cache_dir, ignore_errors=True)
+            tool_cmd.extend(("--cache-dir", cache_dir))
+            run_tool(tool_cmd + sources)
+
+        times = []
+        peak_rss = 0.0
+        for _ in range(repeat):
+            elapsed, rss = run_tool(tool_cmd + sources)
+            times.append(elapsed)
+            peak_rss = max(peak_rss, rss)
+
+        with open(report_path, "r", encoding="utf-8") as file:
+            report = json.load(file)
+
+    # The matches are only counted for the files parsed, not for the ones
+    # whose replacements were loaded from the cache.
+
+    elapsed = median(times)
+    replacements = report["replacements"]
+    matches = sum(x["matches"] for x in report.get("matchers", []))
+    return {
+        "name": name,
+        "files": len(sources),
+        "wall": elapsed,
+        "tus_per_second": len(sources) / elapsed,
+        "matches": matches,
+        "matches_per_second": matches / elapsed,
+        "replacements": replacements,
+        "replacements_per_second": replacements / elapsed,
+        "peak_rss": peak_rss,
+    }
+
+
+def main(path, params, tools, jobs, repeat, cache, output):
+    path = abspath(path)
+    sources = generate(path, params)
+
+    common = []
+    common.extend(("-p", path))
+    common.extend(("--root", path))
+    common.extend(("-j", str(jobs)))
+
+    runs = []
+    if "inline-namespaces" in tools:
+        cmd = [join(EXECUTABLE_DIR, "inline-namespaces")] + common
+        cmd.extend(("--file-pattern", join(path, "*")))
+        cmd.extend(("--policy", join(path, "policy.txt")))
+        runs.append(("inline-namespaces", cmd))
+
+    if "disambiguate-symbols" in tools:
+        cmd = [join(EXECUTABLE_DIR, "disambiguate-symbols")] + common
+        runs.append(("disambiguate-symbols", cmd))
+
+    results = []
+    for name, cmd in runs:
+        cache_dir = join(BUILD_DIR, "cache", "benchmark") if cache else None
+        results.append(benchmark(name, cmd, sources, repeat, cache_dir))
+
+    print(
+        "{:<30} {:>8} {:>9} {:>9} {:>11} {:>8} {:>11} {:>10}".format(
+            "Tool",
+            "Wall (s)",
+            "TUs/s",
+            "Matches",
+            "Matches/s",
+            "Repl.",
+            "Repl./s",
+            "RSS (MiB)",
+        )
+    )
+    for result in results:
+        print(
+            "{name:<30} {wall:>8.2f} {tus_per_second:>9.1f} "
+            "{matches:>9} {matches_per_second:>11.1f} "
+            "{replacements:>8} {replacements_per_second:>11.1f} "
+            "{peak_rss:>10.1f}".format(**result)
+        )
+
+    if output:
+        with open(output, "w", encoding="utf-8") as file:
+            json.dump({"params": params, "results": results}, file, indent=4)
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser()
+    parser.add_argument(
+        "--path",
+        default=BENCHMARK_DIR,
+        help="Directory to generate the synthetic tree into.",
+    )
+    parser.add_argument(
+        "--files",
+        type=int,
+        default=256,
+        help="Number of sources to generate, each with its header.",
+    )
+    parser.add_argument(
+        "--depth",
+        type=int,
+        default=4,
+        help="Number of components of the third-party namespaces.",
+    )
+    parser.add_argument(
+        "--using-density",
+        type=float,
+        default=0.75,
+        help=(
+            "Probability for a source to refer to the symbols of a library "
+            "through ‘using’ directives or declarations."
+        ),
+    )
+    parser.add_argument(
+        "--anonymous-symbols",
+        type=int,
+        default=4,
+        help="Number of functions in an anonymous namespace per source.",
+    )
+    parser.add_argument(
+        "--template-includes",
+        type=int,
+        default=6,
+        help="Number of template-heavy standard headers included per source.",
+    )
+    parser.add_argument(
+        "--seed",
+        type=int,
+        default=0,
+        help="Seed of the random choices made while generating the tree.",
+    )
+    parser.add_argument(
+        "--tool",
+        action="append",
+        choices=("inline-namespaces", "disambiguate-symbols"),
+        help="Tools to run (default: both).",
+    )
+    parser.add_argument(
+        "-j",
+        "--jobs",
+        type=int,
+        default=0,
+        help="Number of files to process in parallel (0: all cores).",
+    )
+    parser.add_argument(
+        "--repeat",
+        type=int,
+        default=3,
+        help="Number of runs per tool, of which the median is reported.",
+    )
+    parser.add_argument(
+        "--cache",
+        action="store_true",
+        help="Measure the runs reusing the replacements cached beforehand.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        help="File to write the parameters and the results to, as JSON.",
+    )
+    args = parser.parse_args()
+
+    params = {
+        "files": args.files,
+        "depth": args.depth,
+        "using_density": args.using_density,
+        "anonymous_symbols": args.anonymous_symbols,
+        "template_includes": args.template_includes,
+        "seed": args.seed,
+    }
+
+    main(
+        args.path,
+        params,
+        args.tool or ("inline-namespaces", "disambiguate-symbols"),
+        args.jobs,
+        max(1, args.repeat),
+        args.cache,
+        args.output,
+    )
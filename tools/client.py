@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Send files to a refactoring tool started with ‘--serve’.
+
+The server keeps the compilation database and the precompiled preambles of
+the files in memory, so running it again on a file only parses what comes
+after its ‘#include’ directives.
+"""
+
+from argparse import ArgumentParser
+from difflib import unified_diff
+import json
+from os.path import abspath
+import socket
+import sys
+
+
+def request(socket_path, data):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.connect(socket_path)
+        client.sendall(json.dumps(data).encode("utf-8"))
+        client.shutdown(socket.SHUT_WR)
+
+        chunks = []
+        while True:
+            chunk = client.recv(65536)
+            if not chunk:
+                break
+
+            chunks.append(chunk)
+
+    return json.loads(b"".join(chunks).decode("utf-8"))
+
+
+def print_diff(files):
+    for file_path, content in sorted(files.items()):
+        with open(file_path, "r", encoding="utf-8") as file:
+            original = file.read()
+
+        sys.stdout.writelines(
+            unified_diff(
+                original.splitlines(keepends=True),
+                content.splitlines(keepends=True),
+                fromfile=file_path,
+                tofile=file_path,
+            )
+        )
+
+
+def print_replacements(replacements):
+    for replacement in replacements:
+        print(
+            "{}:{}:{}: [{}] {!r}".format(
+                replacement["path"],
+                replacement["offset"],
+                replacement["length"],
+                replacement["label"],
+                replacement["text"],
+            )
+        )
+
+
+def write_files(files):
+    for file_path, content in files.items():
+        with open(file_path, "w", encoding="utf-8") as file:
+            file.write(content)
+
+
+def main(socket_path, files, output, overwrite, shutdown):
+    if shutdown:
+        request(socket_path, {"shutdown": True})
+        return 0
+
+    response = request(socket_path, {"files": [abspath(x) for x in files]})
+    if "error" in response:
+        print(response["error"], file=sys.stderr)
+        return 1
+
+    if output == "diff":
+        print_diff(response["files"])
+    elif output == "replacements":
+        print_replacements(response["replacements"])
+
+    if response["conflicts"]:
+        print(
+            "{} conflicting replacements were rejected.".format(
+                response["conflicts"]
+            ),
+            file=sys.stderr,
+        )
+
+    if overwrite:
+        write_files(response["files"])
+
+    return response["status"]
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser()
+    parser.add_argument(
+        "--socket",
+        required=True,
+        help="Socket that the tool was started with.",
+    )
+    parser.add_argument(
+        "--output",
+        choices=("diff", "replacements", "none"),
+        default="diff",
+        help="What to print of the changes found (default: ‘diff’).",
+    )
+    parser.add_argument(
+        "--overwrite",
+        action="store_true",
+        help="Overwrite the files.",
+    )
+    parser.add_argument(
+        "--shutdown",
+        action="store_true",
+        help="Stop the server.",
+    )
+    parser.add_argument(
+        "files",
+        nargs="*",
+        help="Files to refactor.",
+    )
+    args = parser.parse_args()
+
+    sys.exit(
+        main(
+            args.socket,
+            args.files,
+            args.output,
+            args.overwrite,
+            args.shutdown,
+        )
+    )
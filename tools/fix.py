@@ -4,6 +4,7 @@
 """Run the refactoring tool."""
 
 from argparse import ArgumentParser
+from concurrent.futures import ThreadPoolExecutor
 from os import (
     pardir,
     sep,
@@ -16,12 +17,19 @@ from os.path import (
     split,
     splitext,
 )
-from subprocess import run
+from subprocess import (
+    PIPE,
+    run,
+)
 from re import compile as re_compile
+import sys
+from tempfile import TemporaryDirectory
 
 
 ROOT_DIR = abspath(join(dirname(__file__), pardir))
-EXECUTABLE_DIR = join(ROOT_DIR, "build", "bin")
+BUILD_DIR = join(ROOT_DIR, "build")
+EXECUTABLE_DIR = join(BUILD_DIR, "bin")
+UNITS_DIR = join(BUILD_DIR, "units")
 
 VERSIONED_FILE = re_compile(r"_v\d+$")
 
@@ -130,10 +138,116 @@ def filter_file_inline_namespaces(file_path):
 FILTER_FILE_FN = {
     "disambiguate-symbols": filter_file_disambiguate_symbols,
     "inline-namespaces": filter_file_inline_namespaces,
+    "pipeline": filter_file_common,
+}
+
+# Files that the pipeline skips in each of its passes, to match the filters
+# of the tools run on their own.
+PIPELINE_EXCLUDES = {
+    "inline-namespaces": (
+        r"^.*/base/vt/pyOperators\.h$"
+        r"|^.*/usd/pcp/dynamicFileFormatContext\.cpp$"
+    ),
+    "disambiguate-symbols": r"^.*/base/js/.*$",
 }
 
 
-def main(tool, path, modules):
+def make_units(path, files):
+    """Pull the sources into unity units and return the units.
+
+    The headers are left as is, to be refactored on their own or from within
+    the units including them.
+    """
+    sources = [x for x in files if splitext(x)[1] == ".cpp"]
+    headers = [x for x in files if splitext(x)[1] != ".cpp"]
+
+    cmd = ["python3", join(ROOT_DIR, "tools", "unity-compile-commands.py")]
+    cmd.extend(("-p", join(path, "build")))
+    cmd.extend(("-o", UNITS_DIR))
+    cmd.extend(sources)
+
+    process = run(cmd, stdout=PIPE, check=True, universal_newlines=True)
+    return process.stdout.splitlines() + headers
+
+
+def run_shard(cmd, name, files, shard, out_dir):
+    shard_cmd = list(cmd)
+    shard_cmd.extend(("--export-replacements", join(out_dir, name + ".yaml")))
+    shard_cmd.extend(("--timings", join(BUILD_DIR, name + ".timings")))
+
+    if shard is not None:
+        shard_cmd.extend(("--shard", shard))
+
+    shard_cmd.extend(files)
+    return run(shard_cmd).returncode == 0
+
+
+def run_shards(cmd, tool, files, shards, retries, apply_tool):
+    """Run each shard in its own process and apply the results at the end.
+
+    A crash only loses the work of the shard it happens in. Failed shards are
+    retried and, if they still fail, are split into one process per file
+    so that only the faulty files end up being skipped. Return whether all
+    the files were processed and their replacements applied.
+    """
+    with TemporaryDirectory() as out_dir:
+        def run_task(task):
+            name, task_files, shard = task
+            for _ in range(retries + 1):
+                if run_shard(cmd, name, task_files, shard, out_dir):
+                    return None
+
+            return task
+
+        tasks = [
+            ("{}-{}".format(tool, i), files, "{}/{}".format(i, shards))
+            for i in range(shards)
+        ]
+        with ThreadPoolExecutor(max_workers=shards) as executor:
+            failed = [x for x in executor.map(run_task, tasks) if x]
+
+        tasks = []
+        for name, _, shard in failed:
+            index = int(shard.split("/")[0])
+            tasks.extend(
+                ("{}-{}".format(name, i), [x], None)
+                for i, x in enumerate(files[index::shards])
+            )
+
+        with ThreadPoolExecutor(max_workers=shards) as executor:
+            failed = [x for x in executor.map(run_task, tasks) if x]
+
+        for _, task_files, _ in failed:
+            print(
+                "Failed processing the file {}".format(task_files[0]),
+                file=sys.stderr,
+            )
+
+        # Merge and apply all the replacements in a single pass.
+
+        if run((apply_tool, out_dir)).returncode:
+            print("Failed applying the replacements.", file=sys.stderr)
+            return False
+
+        return not failed
+
+
+def main(
+    tool,
+    path,
+    modules,
+    jobs,
+    shards,
+    retries,
+    apply_tool,
+    prefix_header,
+    headers_from_includers,
+    unity_units,
+    stream,
+    policies,
+    cache_dir,
+    cache_files,
+):
     filter_file = FILTER_FILE_FN[tool]
 
     files = []
@@ -143,18 +257,71 @@ def main(tool, path, modules):
             file_paths = (x for x in file_paths if filter_file(x))
             files.extend(x for x in file_paths if x not in files)
 
+    compile_commands_dir = join(path, "build")
+    if unity_units:
+        files = make_units(path, files)
+        compile_commands_dir = UNITS_DIR
+
     cmd = []
     cmd.append(join(EXECUTABLE_DIR, tool))
-    cmd.extend(("-p", join(path, "build")))
-    cmd.append("--overwrite")
+    cmd.extend(("-p", compile_commands_dir))
     cmd.extend(("--root", path))
+    cmd.extend(("-j", str(jobs)))
 
-    if tool == "inline-namespaces":
+    if cache_dir:
+        cmd.extend(("--cache-dir", join(abspath(cache_dir), tool)))
+
+    if cache_files:
+        cmd.append("--cache-files")
+
+    if unity_units:
+        cmd.append("--unity-units")
+
+    if tool in ("inline-namespaces", "pipeline"):
         cmd.extend(("--file-pattern", join(path, "*")))
 
+    if tool in ("inline-namespaces", "pipeline"):
+        for policy in policies:
+            cmd.extend(("--policy", policy))
+
+    if tool == "pipeline":
+        for name, pattern in PIPELINE_EXCLUDES.items():
+            cmd.append("--{}-exclude={}".format(name, pattern))
+
+    if prefix_header:
+        cmd.extend(("--prefix-header", prefix_header))
+        cmd.extend(("--pch-dir", join(BUILD_DIR, "pch")))
+
+    if headers_from_includers:
+        cmd.append("--headers-from-includers")
+
+    if shards > 1:
+        return 0 if run_shards(
+            cmd, tool, files, shards, retries, apply_tool
+        ) else 1
+
+    cmd.append("--overwrite")
+    cmd.extend(("--timings", join(BUILD_DIR, "{}.timings".format(tool))))
+
+    if stream:
+        # The headers can't be streamed, since the sources including them
+        # could be parsed after they are written, so these are refactored
+        # once all the sources are written instead.
+
+        sources = [x for x in files if splitext(x)[1] != ".h"]
+        headers = [x for x in files if splitext(x)[1] == ".h"]
+
+        # Nor are the headers refactored if writing the sources failed.
+
+        status = run(cmd + ["--stream"] + sources).returncode
+        if status or not headers:
+            return status
+
+        return run(cmd + headers).returncode
+
     cmd.extend(files)
 
-    run(cmd)
+    return run(cmd).returncode
 
 
 if __name__ == "__main__":
@@ -162,13 +329,101 @@ if __name__ == "__main__":
     parser.add_argument(
         "--tool",
         required=True,
-        help="Either ‘inline-namespaces’ or ‘disambiguate-symbols’."
+        help=(
+            "Either ‘inline-namespaces’, ‘disambiguate-symbols’, or "
+            "‘pipeline’ to run both one after the other."
+        )
     )
     parser.add_argument(
         "--path",
         required=True,
         help="Path to USD's root directory."
     )
+    parser.add_argument(
+        "-j",
+        "--jobs",
+        type=int,
+        default=1,
+        help="Number of files to process in parallel (0: all cores).",
+    )
+    parser.add_argument(
+        "--shards",
+        type=int,
+        default=1,
+        help=(
+            "Number of processes to split the files across. Not supported by "
+            "the pipeline."
+        ),
+    )
+    parser.add_argument(
+        "--retries",
+        type=int,
+        default=1,
+        help="Number of times to retry a shard that failed.",
+    )
+    parser.add_argument(
+        "--apply-tool",
+        default="clang-apply-replacements-14",
+        help="Tool merging and applying the replacements exported by shards.",
+    )
+    parser.add_argument(
+        "--prefix-header",
+        help=(
+            "Header made of the includes that most files start with, to "
+            "precompile once per set of compile flags."
+        ),
+    )
+    parser.add_argument(
+        "--headers-from-includers",
+        action="store_true",
+        help=(
+            "Refactor the headers from within the first file including them "
+            "rather than on their own."
+        ),
+    )
+    parser.add_argument(
+        "--unity-units",
+        action="store_true",
+        help=(
+            "Pull the sources into one unit per target and per compile flags, "
+            "and refactor them from within these units. Only supported by "
+            "‘inline-namespaces’."
+        ),
+    )
+    parser.add_argument(
+        "--stream",
+        action="store_true",
+        help=(
+            "Write each source as soon as it is processed rather than all of "
+            "them at the end, and the headers once all the sources are "
+            "written. Not supported by the pipeline, with shards, nor when "
+            "refactoring the headers from their includers."
+        ),
+    )
+    parser.add_argument(
+        "--policy",
+        action="append",
+        default=[],
+        help=(
+            "File with more rules deciding which namespaces to inline, on top "
+            "of the default ones. Can be given more than once."
+        ),
+    )
+    parser.add_argument(
+        "--cache-dir",
+        help=(
+            "Directory caching the replacements found in each file, in a "
+            "subdirectory per tool, to reuse on the next runs."
+        ),
+    )
+    parser.add_argument(
+        "--cache-files",
+        action="store_true",
+        help=(
+            "Cache the status and the content of the files read, shared "
+            "across all the files processed."
+        ),
+    )
     parser.add_argument(
         "modules",
         nargs="*",
@@ -177,4 +432,46 @@ if __name__ == "__main__":
     )
     args = parser.parse_args()
 
-    main(args.tool, args.path, args.modules)
+    # The pipeline exports each file as a whole, so two shards changing
+    # the same header would export conflicting replacements for it.
+
+    if args.tool == "pipeline" and args.shards > 1:
+        parser.error("the pipeline can't be split into shards")
+
+    # The headers refactored from their includers are written along with
+    # them, while the other sources including them might still be parsed.
+
+    if args.stream and args.headers_from_includers:
+        parser.error(
+            "the headers can't be refactored from their includers when "
+            "streaming"
+        )
+
+    # The shards export their replacements to be applied once they are all
+    # done, which leaves nothing to stream.
+
+    if args.stream and args.shards > 1:
+        parser.error("the shards can't stream their files")
+
+    # The sources whose anonymous namespaces have clashing symbols, which are
+    # the ones that ‘disambiguate-symbols’ fixes, can't be compiled together.
+
+    if args.unity_units and args.tool != "inline-namespaces":
+        parser.error("only ‘inline-namespaces’ can refactor unity units")
+
+    sys.exit(main(
+        args.tool,
+        args.path,
+        args.modules,
+        args.jobs,
+        args.shards,
+        args.retries,
+        args.apply_tool,
+        args.prefix_header,
+        args.headers_from_includers,
+        args.unity_units,
+        args.stream,
+        args.policy,
+        args.cache_dir,
+        args.cache_files,
+    ))
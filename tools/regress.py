@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Compare the output and the timings of the tools against a baseline.
+
+Both tools are run over a pinned subset of USD's modules, with the same file
+filters as ‘fix.py’, exporting their replacements rather than applying them.
+For each tool and each module, the wall time, the time spent in the matchers,
+and a hash of the replacements exported are recorded.
+
+Any change in the replacements is a failure, and so is a time exceeding its
+baseline by more than the tolerance. The number of files and replacements,
+and their hash, only depend on the USD revision that they were recorded from,
+and are committed along with the tools. The timings depend on the machine that
+they were recorded on, and are kept in a local file instead, the times only
+being compared once recorded there. Both are recorded again with ‘--update’.
+"""
+
+from argparse import ArgumentParser
+from hashlib import sha256
+import json
+from os import (
+    makedirs,
+    pardir,
+    walk,
+)
+from os.path import (
+    abspath,
+    dirname,
+    isfile,
+    join,
+)
+from statistics import median
+from subprocess import (
+    DEVNULL,
+    PIPE,
+    run,
+)
+import sys
+from tempfile import TemporaryDirectory
+from time import perf_counter
+
+from fix import FILTER_FILE_FN
+
+
+ROOT_DIR = abspath(join(dirname(__file__), pardir))
+BUILD_DIR = join(ROOT_DIR, "build")
+EXECUTABLE_DIR = join(BUILD_DIR, "bin")
+BASELINE_PATH = join(ROOT_DIR, "tests", "regress", "baseline.json")
+TIMINGS_PATH = join(ROOT_DIR, "tests", "regress", "timings.local.json")
+
+TOOLS = ("inline-namespaces", "disambiguate-symbols")
+
+MODULES = (
+    "pxr/base/tf",
+    "pxr/usd/sdf",
+    "pxr/imaging/hd",
+)
+
+# Root of USD's sources as spelled in the replacements exported, so that
+# the hash doesn't depend on where USD is checked out.
+ROOT_PLACEHOLDER = "<root>"
+
+
+# Fields of the results recorded in the baseline, and in the timings.
+BASELINE_FIELDS = ("files", "replacements", "hash")
+TIMING_FIELDS = ("wall", "matchers")
+
+
+def get_revision(path):
+    process = run(
+        ("git", "-C", path, "rev-parse", "HEAD"),
+        stdout=PIPE,
+        check=True,
+        universal_newlines=True,
+    )
+    return process.stdout.strip()
+
+
+def get_files(path, tool, module):
+    filter_file = FILTER_FILE_FN[tool]
+    files = []
+    for root, _, file_names in walk(join(path, module)):
+        file_paths = (join(root, x) for x in sorted(file_names))
+        files.extend(x for x in file_paths if filter_file(x))
+
+    return sorted(files)
+
+
+def run_tool(path, tool, files, jobs, out_dir):
+    """Run the tool once and return its wall and matcher times, and hash."""
+    export_path = join(out_dir, "replacements.yaml")
+    report_path = join(out_dir, "report.json")
+
+    cmd = []
+    cmd.append(join(EXECUTABLE_DIR, tool))
+    cmd.extend(("-p", join(path, "build")))
+    cmd.extend(("--root", path))
+    cmd.extend(("-j", str(jobs)))
+    cmd.extend(("--export-replacements", export_path))
+    cmd.append("--report=json")
+    cmd.extend(("--report-file", report_path))
+    cmd.append("--profile-matchers")
+
+    if tool == "inline-namespaces":
+        cmd.extend(("--file-pattern", join(path, "*")))
+
+    cmd.extend(files)
+
+    start = perf_counter()
+    process = run(cmd, stdout=DEVNULL)
+    wall = perf_counter() - start
+    if process.returncode:
+        raise RuntimeError("Failed running the tool ‘{}’".format(tool))
+
+    with open(report_path, "r", encoding="utf-8") as file:
+        report = json.load(file)
+
+    matchers = sum(
+        x["user"] + x["system"] for x in report.get("matchers", [])
+    )
+
+    with open(export_path, "r", encoding="utf-8") as file:
+        exported = file.read().replace(path, ROOT_PLACEHOLDER)
+
+    return {
+        "wall": wall,
+        "matchers": matchers,
+        "replacements": report["replacements"],
+        "hash": sha256(exported.encode("utf-8")).hexdigest(),
+    }
+
+
+def measure(path, tools, modules, jobs, repeat):
+    results = {}
+    for tool in tools:
+        for module in modules:
+            files = get_files(path, tool, module)
+            runs = []
+            with TemporaryDirectory() as out_dir:
+                for _ in range(repeat):
+                    runs.append(run_tool(path, tool, files, jobs, out_dir))
+
+            # The output of each run is expected to be the same, whereas
+            # the timings are noisy.
+
+            hashes = set(x["hash"] for x in runs)
+            if len(hashes) > 1:
+                raise RuntimeError(
+                    "The tool ‘{}’ gave different outputs for the module "
+                    "‘{}’ across runs".format(tool, module)
+                )
+
+            key = "{}:{}".format(tool, module)
+            results[key] = {
+                "files": len(files),
+                "wall": median(x["wall"] for x in runs),
+                "matchers": median(x["matchers"] for x in runs),
+                "replacements": runs[0]["replacements"],
+                "hash": runs[0]["hash"],
+            }
+
+            print(
+                "{:<40} {:>8.2f} s {:>8.2f} s {:>8} replacements".format(
+                    key,
+                    results[key]["wall"],
+                    results[key]["matchers"],
+                    results[key]["replacements"],
+                )
+            )
+
+    return results
+
+
+def compare(baseline, timings, current, tolerance, slack):
+    """Return the list of regressions of the current results."""
+    failures = []
+    for key, result in sorted(current.items()):
+        expected = baseline.get(key)
+        if expected is None:
+            failures.append("{}: no baseline".format(key))
+            continue
+
+        if result["hash"] != expected["hash"]:
+            failures.append(
+                "{}: the replacements changed ({} replacements, {} in the "
+                "baseline)".format(
+                    key, result["replacements"], expected["replacements"]
+                )
+            )
+
+        expected = timings.get(key)
+        if expected is None:
+            continue
+
+        for phase in TIMING_FIELDS:
+            limit = expected[phase] * (1.0 + tolerance) + slack
+            if result[phase] > limit:
+                failures.append(
+                    "{}: the {} time regressed from {:.2f} s to {:.2f} s "
+                    "(limit: {:.2f} s)".format(
+                        key, phase, expected[phase], result[phase], limit
+                    )
+                )
+
+    return failures
+
+
+def load(path):
+    if not isfile(path):
+        return None
+
+    with open(path, "r", encoding="utf-8") as file:
+        return json.load(file)
+
+
+def dump(path, data):
+    makedirs(dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8") as file:
+        json.dump(data, file, indent=4, sort_keys=True)
+        file.write("\n")
+
+
+def main(
+    path,
+    tools,
+    modules,
+    jobs,
+    repeat,
+    baseline_path,
+    timings_path,
+    tolerance,
+    slack,
+    update,
+):
+    path = abspath(path)
+    revision = get_revision(path)
+
+    baseline = None
+    timings = None
+    if not update:
+        baseline = load(baseline_path)
+        if baseline is None:
+            print(
+                "No baseline recorded at {}, record one with ‘--update’ "
+                "and commit it."
+                .format(baseline_path),
+                file=sys.stderr,
+            )
+            return 1
+
+        if baseline["revision"] != revision:
+            print(
+                "The baseline was recorded from USD's revision {}, not {}, "
+                "record it again with ‘--update’."
+                .format(baseline["revision"], revision),
+                file=sys.stderr,
+            )
+            return 1
+
+        # The timings recorded elsewhere than on this machine, or in other
+        # conditions, aren't worth comparing against.
+
+        timings = load(timings_path)
+        if timings is None:
+            print(
+                "No timings recorded at {}, only comparing the replacements."
+                .format(timings_path)
+            )
+        elif timings["revision"] != revision or timings["jobs"] != jobs:
+            print(
+                "The timings at {} were recorded from USD's revision {} with "
+                "{} jobs, only comparing the replacements."
+                .format(timings_path, timings["revision"], timings["jobs"])
+            )
+            timings = None
+
+    results = measure(path, tools, modules, jobs, repeat)
+
+    if update:
+        dump(
+            baseline_path,
+            {
+                "revision": revision,
+                "results": {
+                    key: {x: result[x] for x in BASELINE_FIELDS}
+                    for key, result in results.items()
+                },
+            },
+        )
+        dump(
+            timings_path,
+            {
+                "revision": revision,
+                "jobs": jobs,
+                "results": {
+                    key: {x: result[x] for x in TIMING_FIELDS}
+                    for key, result in results.items()
+                },
+            },
+        )
+
+        print(
+            "Recorded the baseline to {}, and the timings to {}."
+            .format(baseline_path, timings_path)
+        )
+        return 0
+
+    failures = compare(
+        baseline["results"],
+        timings["results"] if timings else {},
+        results,
+        tolerance,
+        slack,
+    )
+    if failures:
+        print("\nREGRESSIONS:", file=sys.stderr)
+        for failure in failures:
+            print("  {}".format(failure), file=sys.stderr)
+
+        return 1
+
+    print("\nNo regressions.")
+    return 0
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser()
+    parser.add_argument(
+        "--path",
+        required=True,
+        help="Path to USD's root directory.",
+    )
+    parser.add_argument(
+        "--tool",
+        action="append",
+        choices=TOOLS,
+        help="Tools to run (default: both).",
+    )
+    parser.add_argument(
+        "--module",
+        action="append",
+        help="USD modules making the corpus (default: {}).".format(
+            ", ".join("‘{}’".format(x) for x in MODULES)
+        ),
+    )
+    parser.add_argument(
+        "-j",
+        "--jobs",
+        type=int,
+        default=0,
+        help="Number of files to process in parallel (0: all cores).",
+    )
+    parser.add_argument(
+        "--repeat",
+        type=int,
+        default=3,
+        help="Number of runs per tool and module, keeping the median.",
+    )
+    parser.add_argument(
+        "--baseline",
+        default=BASELINE_PATH,
+        help="File holding the baseline of the replacements.",
+    )
+    parser.add_argument(
+        "--timings",
+        default=TIMINGS_PATH,
+        help="Local file holding the baseline of the timings.",
+    )
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=0.1,
+        help="Relative increase of a time over its baseline to tolerate.",
+    )
+    parser.add_argument(
+        "--slack",
+        type=float,
+        default=0.5,
+        help="Seconds added to the tolerance, to absorb the noise.",
+    )
+    parser.add_argument(
+        "--update",
+        action="store_true",
+        help="Record the baseline instead of comparing against it.",
+    )
+    args = parser.parse_args()
+
+    sys.exit(
+        main(
+            args.path,
+            args.tool or TOOLS,
+            args.module or MODULES,
+            args.jobs,
+            max(1, args.repeat),
+            args.baseline,
+            args.timings,
+            args.tolerance,
+            args.slack,
+            args.update,
+        )
+    )
@@ -12,10 +12,10 @@ from os import (
 )
 from os.path import (
     abspath,
-    basename,
     dirname,
+    isfile,
     join,
-    splitext,
+    realpath,
 )
 from subprocess import (
     DEVNULL,
@@ -28,7 +28,66 @@ ROOT_DIR = abspath(join(dirname(__file__), pardir))
 TEST_DIR = join(ROOT_DIR, "tests")
 EXECUTABLE = join(ROOT_DIR, "build", "bin", "inline-namespaces")
 
-Test = namedtuple("Test", ("name", "original", "expected"))
+# Lines framing each file dumped by the tools.
+DUMP_PREFIX = "============== "
+DUMP_SUFFIX = " =============="
+DUMP_END = "=" * 44
+
+# Each test may also hold a header that its source includes, refactored from
+# within the source rather than on its own, and a policy with more rules
+# deciding which namespaces to inline.
+Test = namedtuple(
+    "Test",
+    (
+        "name",
+        "original",
+        "expected",
+        "original_header",
+        "expected_header",
+        "policy",
+    ),
+)
+
+
+def parse_dump(output):
+    """Return the lines of each file dumped, keyed on their real path."""
+    files = {}
+    lines = None
+    for line in output.split("\n"):
+        if line.startswith(DUMP_PREFIX) and line.endswith(DUMP_SUFFIX):
+            path = line[len(DUMP_PREFIX):-len(DUMP_SUFFIX)]
+            lines = files.setdefault(realpath(path), [])
+        elif line == DUMP_END:
+            lines = None
+        elif lines is not None:
+            lines.append(line)
+
+    return files
+
+
+def read_lines(path):
+    with open(path) as file:
+        return file.read().split("\n")
+
+
+def diff_file(test, modified, original, expected):
+    modified = modified.get(realpath(original))
+    if modified is None:
+        # No changes were made.
+        modified = read_lines(original)
+
+    diffs = unified_diff(modified, read_lines(expected))
+    diffs = "\n".join(diffs)
+    if not diffs:
+        return []
+
+    title = "Diff for test ‘{}’ ".format(test.name)
+    return [
+        "\n{} {:=<74}\n".format("=" * 5, title),
+        "~" * 80,
+        diffs,
+        "~" * 80,
+    ]
 
 
 def run_test(test, path, verbose):
@@ -36,9 +95,16 @@ def run_test(test, path, verbose):
     cmd.append(EXECUTABLE)
     cmd.append("--dump")
     cmd.extend(("-p", join(path, "build")))
-    cmd.extend(("--file-pattern", join(path, "*")))
+    cmd.extend(("--file-pattern", join(TEST_DIR, "*")))
     cmd.append(test.original)
 
+    if test.original_header:
+        cmd.append("--headers-from-includers")
+        cmd.append(test.original_header)
+
+    if test.policy:
+        cmd.extend(("--policy", test.policy))
+
     if verbose:
         title = "Running test ‘{}’ ".format(test.name)
         print("\n{} {:=<74}\n".format("=" * 5, title))
@@ -49,31 +115,17 @@ def run_test(test, path, verbose):
     if result.returncode:
         raise RuntimeError("Error while refactoring the file")
 
-    if result.stdout:
-        modified = result.stdout.decode("utf-8")
-        modified = modified.split("\n")[1:-2]
-    else:
-        # No changes were made.
-        with open(test.original) as file:
-            modified = file.read()
-            modified = modified.split("\n")
-
-    with open(test.expected) as file:
-        expected = file.read()
-        expected = expected.split("\n")
-
-    diffs = unified_diff(modified, expected)
-    diffs = "\n".join(diffs)
-    if not diffs:
-        return []
+    modified = parse_dump(result.stdout.decode("utf-8"))
+    outputs = diff_file(test, modified, test.original, test.expected)
+    if test.original_header:
+        outputs += diff_file(
+            test,
+            modified,
+            test.original_header,
+            test.expected_header,
+        )
 
-    title = "Diff for test ‘{}’ ".format(test.name)
-    return [
-        "\n{} {:=<74}\n".format("=" * 5, title),
-        "~" * 80,
-        diffs,
-        "~" * 80,
-    ]
+    return outputs
 
 
 def main(path, tool_names, test_names, verbose):
@@ -90,8 +142,21 @@ def main(path, tool_names, test_names, verbose):
             ):
                 continue
 
-            files = {splitext(basename(x))[0]: x.path for x in scandir(entry)}
-            test = Test(name=entry.name, **files)
+            original_header = join(entry.path, "header", "original.h")
+            has_header = isfile(original_header)
+            policy = join(entry.path, "policy.txt")
+            test = Test(
+                name=entry.name,
+                original=join(entry.path, "original.cpp"),
+                expected=join(entry.path, "expected.cpp"),
+                original_header=original_header if has_header else None,
+                expected_header=(
+                    join(entry.path, "header", "expected.h")
+                    if has_header
+                    else None
+                ),
+                policy=policy if isfile(policy) else None,
+            )
             tests.append(test)
 
     outputs = []
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Generate unity units and their compilation database from USD's build.
+
+The sources of each target that share the same compile flags are pulled into
+a single unit made of ‘#include’ directives, the same way as USD's unity build
+does, so that running the refactoring tools with ‘--unity-units’ on the units
+only parses the headers shared by these sources once.
+
+The database written lists the units along with the original entries, which
+remain useful to infer the compile flags of the headers. The sources whose
+target can't be told from their object are left out of the units, and listed
+along with them to be refactored on their own.
+"""
+
+from argparse import ArgumentParser
+from collections import OrderedDict
+import json
+from os import makedirs
+from os.path import (
+    abspath,
+    join,
+    normpath,
+    splitext,
+)
+from re import compile as re_compile
+from shlex import (
+    quote,
+    split,
+)
+
+
+SOURCE_EXTENSIONS = (".c", ".cc", ".cpp", ".cxx")
+
+TARGET_DIR = re_compile(r"CMakeFiles/(?P<target>[^/]+)\.dir/")
+
+
+def get_arguments(entry):
+    if "arguments" in entry:
+        return list(entry["arguments"])
+
+    return split(entry["command"])
+
+
+def get_source_path(entry):
+    return normpath(join(entry["directory"], entry["file"]))
+
+
+# Flags naming the dependency file written along with each object, and its
+# targets, which differ for each source. These are dropped along with their
+# value, given either separately or joined to the flag.
+DEPENDENCY_FLAGS_WITH_VALUE = ("-MF", "-MT", "-MQ", "-MJ")
+
+# Flags only asking for the dependency file to be written.
+DEPENDENCY_FLAGS = ("-MD", "-MMD", "-MP")
+
+
+def split_output(arguments, directory, source_path):
+    """Separate the output and the source file from the compile flags.
+
+    The flags naming the source, its object, or its dependency file differ
+    for each source, and are left out for the sources to be grouped on the
+    flags that they share.
+    """
+    flags = []
+    output = None
+    i = 0
+    while i < len(arguments):
+        argument = arguments[i]
+        has_value = i + 1 < len(arguments)
+        if argument == "-o" and has_value:
+            output = arguments[i + 1]
+            i += 2
+            continue
+
+        if argument.startswith("-o") and len(argument) > 2:
+            output = argument[2:]
+            i += 1
+            continue
+
+        if argument == "-c":
+            i += 1
+            continue
+
+        if argument in DEPENDENCY_FLAGS_WITH_VALUE and has_value:
+            i += 2
+            continue
+
+        if (
+            argument in DEPENDENCY_FLAGS
+            or argument.startswith(DEPENDENCY_FLAGS_WITH_VALUE)
+        ):
+            i += 1
+            continue
+
+        if (
+            not argument.startswith("-")
+            and normpath(join(directory, argument)) == source_path
+        ):
+            i += 1
+            continue
+
+        flags.append(argument)
+        i += 1
+
+    return flags, output
+
+
+def main(build_path, out_path, max_members, files):
+    build_path = abspath(build_path)
+    out_path = abspath(out_path)
+    file_path = join(build_path, "compile_commands.json")
+
+    with open(file_path, "r", encoding="utf-8") as file:
+        data = json.load(file)
+
+    files = set(abspath(x) for x in files)
+
+    # Group the sources per target and per compile flags, in the order of
+    # the original database.
+
+    groups = OrderedDict()
+    standalone = []
+    for entry in data:
+        source_path = get_source_path(entry)
+        if splitext(source_path)[1] not in SOURCE_EXTENSIONS:
+            continue
+
+        if files and source_path not in files:
+            continue
+
+        flags, output = split_output(
+            get_arguments(entry), entry["directory"], source_path
+        )
+        match = TARGET_DIR.search(output or "")
+        if match is None:
+            standalone.append(source_path)
+            continue
+
+        key = (match.group("target"), entry["directory"], tuple(flags))
+        groups.setdefault(key, []).append(source_path)
+
+    makedirs(out_path, exist_ok=True)
+
+    units = []
+    names = {}
+    for (target, directory, flags), members in groups.items():
+        size = max_members or len(members)
+        chunks = [members[i:i + size] for i in range(0, len(members), size)]
+        for chunk in chunks:
+            index = names.get(target, 0)
+            names[target] = index + 1
+            name = (
+                "{}_unit.cpp".format(target)
+                if index == 0
+                else "{}_unit_{}.cpp".format(target, index)
+            )
+
+            unit_path = join(out_path, name)
+            content = "".join("#include <{}>\n".format(x) for x in chunk)
+
+            # Leave the units untouched when their content didn't change, for
+            # the caches keyed on their modification time to remain valid.
+
+            try:
+                with open(unit_path, "r", encoding="utf-8") as file:
+                    previous = file.read()
+            except OSError:
+                previous = None
+
+            if content != previous:
+                with open(unit_path, "w", encoding="utf-8") as file:
+                    file.write(content)
+
+            arguments = list(flags)
+            arguments.extend(("-o", unit_path + ".o"))
+            arguments.extend(("-c", unit_path))
+            units.append(
+                {
+                    "directory": directory,
+                    "command": " ".join(quote(x) for x in arguments),
+                    "file": unit_path,
+                }
+            )
+
+    with open(
+        join(out_path, "compile_commands.json"), "w", encoding="utf-8"
+    ) as file:
+        json.dump(units + data, file, indent=4)
+
+    for unit in units:
+        print(unit["file"])
+
+    for source_path in standalone:
+        print(source_path)
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser()
+    parser.add_argument(
+        "-p",
+        "--path",
+        required=True,
+        help="Path to the build directory holding ‘compile_commands.json’.",
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        required=True,
+        help="Directory to write the units and their database to.",
+    )
+    parser.add_argument(
+        "--max-members",
+        type=int,
+        default=0,
+        help="Maximum number of sources per unit (0: no limit).",
+    )
+    parser.add_argument(
+        "files",
+        nargs="*",
+        help="Sources to pull into the units (default: all of them).",
+    )
+    args = parser.parse_args()
+
+    main(args.path, args.output, args.max_members, args.files)